@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "tqdm/tqdm.h"
+
+/* Compares TQDM_FOR against a raw for-loop over the same body.
+ * Usage: bench_loop [iterations]   (bar output goes to stderr) */
+
+#define DEFAULT_ITERATIONS 200000000
+
+static double get_time_s(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/* Keeps the loop body from being optimised away */
+static volatile unsigned sink;
+
+static double bench_raw(int iterations) {
+  double start = get_time_s();
+  unsigned acc = 0;
+  for (int i = 0; i < iterations; i++) {
+    acc += (unsigned)i * 2654435761u;
+  }
+  sink = acc;
+  return get_time_s() - start;
+}
+
+static double bench_tqdm_for(int iterations) {
+  double start = get_time_s();
+  unsigned acc = 0;
+  TQDM_FOR(int, i, 0, iterations) {
+    acc += (unsigned)i * 2654435761u;
+  }
+  sink = acc;
+  return get_time_s() - start;
+}
+
+int main(int argc, char **argv) {
+  int iterations = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+  if (iterations <= 0) {
+    fprintf(stderr, "iterations must be positive\n");
+    return 1;
+  }
+
+  /* Warm up caches and the clock */
+  bench_raw(iterations / 10);
+
+  double raw = bench_raw(iterations);
+  double tqdm = bench_tqdm_for(iterations);
+
+  printf("=== TQDM_FOR vs raw loop (%d iterations) ===\n", iterations);
+  printf("raw for-loop : %8.3f s  %6.3f ns/iter\n", raw,
+         raw * 1e9 / iterations);
+  printf("TQDM_FOR     : %8.3f s  %6.3f ns/iter\n", tqdm,
+         tqdm * 1e9 / iterations);
+  printf("overhead     : %+8.3f ns/iter\n", (tqdm - raw) * 1e9 / iterations);
+  return 0;
+}
@@ -0,0 +1,259 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "tqdm/tqdm.h"
+
+/* Multithreaded update throughput. Each writer thread owns one bar of a
+ * contiguous array; a reader thread keeps polling every bar's config and
+ * render state, as a dashboard or monitor would. Cache lines shared between
+ * a bar's counters and the fields the reader touches show up as lost
+ * writer throughput.
+ *
+ * The layout rows run one workload, the locked counter step of an update
+ * against the same reader, on the cache-line grouped tqdm_t and on a copy
+ * of the packed field order tqdm_t had before it, so the two can be
+ * compared on one machine.
+ * Usage: bench_threads [threads] [updates per thread] [all|packed|aligned]
+ */
+
+#define DEFAULT_UPDATES 5000000
+#define MAX_THREADS 64
+
+static tqdm_t bars[MAX_THREADS];
+
+/* tqdm_t's field order before the cache-line grouping: the counters, the
+ * params the reader polls and the mutex share lines */
+typedef struct {
+  void *current;
+  void *end;
+  size_t element_size;
+  size_t n;
+  size_t count;
+  tqdm_params_t params;
+  double start_time;
+  double last_print_time;
+  size_t last_print_count;
+  bool closed;
+  bool paused;
+  double pause_start;
+  double total_pause_time;
+  double *rate_history;
+  size_t rate_history_size;
+  size_t rate_history_idx;
+  double cached_rate;
+  double last_rate_calc_time;
+  size_t last_rate_calc_n;
+  int cached_terminal_width;
+  double last_terminal_check;
+  char display_buffer[1024];
+  pthread_mutex_t lock;
+  bool iterator_mode;
+  void *iterator_state;
+  void *(*next_func)(void *state);
+  bool (*has_next_func)(void *state);
+  void (*destroy_func)(void *state);
+} packed_bar_t;
+
+static packed_bar_t packed_bars[MAX_THREADS];
+static volatile int readers_running;
+static volatile size_t reader_sink;
+
+static double get_time_s(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+typedef struct {
+  tqdm_t *bar;
+  int index;
+  size_t updates;
+} writer_args_t;
+
+static void *writer(void *arg) {
+  writer_args_t *w = arg;
+  for (size_t i = 0; i < w->updates; i++) {
+    tqdm_update(w->bar);
+  }
+  return NULL;
+}
+
+/* The layout workload: the part of an update that touches the bar, and a
+ * reader polling what a dashboard would. The fields have the same names in
+ * both layouts. */
+#define LAYOUT_STEP(b)                                                       \
+  do {                                                                       \
+    pthread_mutex_lock(&(b)->lock);                                          \
+    (b)->n++;                                                                \
+    if (!(b)->closed &&                                                      \
+        (b)->n - (b)->last_print_count > (b)->params.miniters)               \
+      (b)->count++;                                                          \
+    pthread_mutex_unlock(&(b)->lock);                                        \
+  } while (0)
+
+#define LAYOUT_POLL(b)                                                       \
+  ((b)->params.total + (b)->params.miniters +                                \
+   (size_t)(b)->last_print_time + (b)->closed)
+
+#define LAYOUT_THREADS(name, type, array)                                    \
+  static void *name##_writer(void *arg) {                                    \
+    writer_args_t *w = arg;                                                  \
+    type *b = &array[w->index];                                              \
+    for (size_t i = 0; i < w->updates; i++)                                  \
+      LAYOUT_STEP(b);                                                        \
+    return NULL;                                                             \
+  }                                                                          \
+  static void *name##_reader(void *arg) {                                    \
+    int nbars = *(int *)arg;                                                 \
+    size_t acc = 0;                                                          \
+    while (readers_running) {                                                \
+      for (int i = 0; i < nbars; i++)                                        \
+        acc += LAYOUT_POLL(&array[i]);                                       \
+    }                                                                        \
+    reader_sink = acc;                                                       \
+    return NULL;                                                             \
+  }
+
+static void *reader(void *arg) {
+  int nbars = *(int *)arg;
+  size_t acc = 0;
+  while (readers_running) {
+    for (int i = 0; i < nbars; i++) {
+      acc += bars[i].params.total + bars[i].params.miniters;
+      acc += (size_t)bars[i].last_print_time;
+      acc += bars[i].closed;
+    }
+  }
+  reader_sink = acc;
+  return NULL;
+}
+
+LAYOUT_THREADS(aligned, tqdm_t, bars)
+LAYOUT_THREADS(packed, packed_bar_t, packed_bars)
+
+/* Writers plus one reader; returns M updates/s */
+static double run_threads(int nthreads, size_t updates,
+                          void *(*write_fn)(void *),
+                          void *(*read_fn)(void *)) {
+  pthread_t readers;
+  readers_running = 1;
+  if (read_fn)
+    pthread_create(&readers, NULL, read_fn, &nthreads);
+
+  pthread_t threads[MAX_THREADS];
+  writer_args_t args[MAX_THREADS];
+  double start = get_time_s();
+  for (int i = 0; i < nthreads; i++) {
+    args[i].bar = &bars[i];
+    args[i].index = i;
+    args[i].updates = updates;
+    pthread_create(&threads[i], NULL, write_fn, &args[i]);
+  }
+  for (int i = 0; i < nthreads; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  double elapsed = get_time_s() - start;
+
+  readers_running = 0;
+  if (read_fn)
+    pthread_join(readers, NULL);
+
+  return (double)updates * nthreads / elapsed / 1e6;
+}
+
+static double run_layout(int nthreads, size_t updates, bool packed,
+                         FILE *sink) {
+  tqdm_params_t params = tqdm_default_params();
+  params.total = updates;
+  params.file = sink;
+  params.leave = false;
+  double rate;
+
+  if (packed) {
+    memset(packed_bars, 0, sizeof(packed_bars));
+    for (int i = 0; i < nthreads; i++) {
+      packed_bars[i].params = params;
+      pthread_mutex_init(&packed_bars[i].lock, NULL);
+    }
+    rate = run_threads(nthreads, updates, packed_writer, packed_reader);
+    for (int i = 0; i < nthreads; i++)
+      pthread_mutex_destroy(&packed_bars[i].lock);
+  } else {
+    for (int i = 0; i < nthreads; i++)
+      tqdm_init(&bars[i], &params);
+    rate = run_threads(nthreads, updates, aligned_writer, aligned_reader);
+    for (int i = 0; i < nthreads; i++)
+      tqdm_fini(&bars[i]);
+  }
+  tqdm_cleanup_params(&params);
+  return rate;
+}
+
+static double run(int nthreads, size_t updates, bool with_reader,
+                  FILE *sink) {
+  tqdm_params_t params = tqdm_default_params();
+  params.total = updates;
+  params.file = sink;
+  params.leave = false;
+
+  for (int i = 0; i < nthreads; i++) {
+    tqdm_init(&bars[i], &params);
+  }
+
+  double rate =
+      run_threads(nthreads, updates, writer, with_reader ? reader : NULL);
+
+  for (int i = 0; i < nthreads; i++) {
+    tqdm_fini(&bars[i]);
+  }
+  tqdm_cleanup_params(&params);
+
+  return rate;
+}
+
+int main(int argc, char **argv) {
+  long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  int nthreads = argc > 1 ? atoi(argv[1]) : (int)(ncpu > 1 ? ncpu - 1 : 1);
+  size_t updates = argc > 2 ? (size_t)atoll(argv[2]) : DEFAULT_UPDATES;
+  const char *mode = argc > 3 ? argv[3] : "all";
+  bool all = !strcmp(mode, "all");
+  if (!all && strcmp(mode, "packed") && strcmp(mode, "aligned")) {
+    fprintf(stderr, "mode must be all, packed or aligned\n");
+    return 1;
+  }
+  if (nthreads < 1)
+    nthreads = 1;
+  if (nthreads > MAX_THREADS)
+    nthreads = MAX_THREADS;
+
+  FILE *sink = fopen("/dev/null", "w");
+  if (!sink) {
+    perror("/dev/null");
+    return 1;
+  }
+
+  printf("=== Multithreaded updates (%d threads, %zu updates each) ===\n",
+         nthreads, updates);
+  if (all) {
+    printf("sizeof(tqdm_t) = %zu\n", sizeof(tqdm_t));
+    printf("writers only   : %8.2f M updates/s\n",
+           run(nthreads, updates, false, sink));
+    printf("with reader    : %8.2f M updates/s\n",
+           run(nthreads, updates, true, sink));
+  }
+
+  printf("--- Layout, writers + reader ---\n");
+  if (all || !strcmp(mode, "packed"))
+    printf("packed  (%4zu B): %8.2f M updates/s\n", sizeof(packed_bar_t),
+           run_layout(nthreads, updates, true, sink));
+  if (all || !strcmp(mode, "aligned"))
+    printf("aligned (%4zu B): %8.2f M updates/s\n", sizeof(tqdm_t),
+           run_layout(nthreads, updates, false, sink));
+
+  fclose(sink);
+  return 0;
+}
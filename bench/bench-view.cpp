@@ -0,0 +1,66 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "tqdm/tqdm.hpp"
+
+/* Compares tqdm::view against a plain range-for over the same vector.
+ * Usage: bench_view [iterations]   (bar output goes to stderr) */
+
+#define DEFAULT_ITERATIONS 200000000
+
+static double get_time_s(void) {
+  using clock = std::chrono::steady_clock;
+  return std::chrono::duration<double>(clock::now().time_since_epoch())
+      .count();
+}
+
+/* Keeps the loop body from being optimised away */
+static volatile unsigned sink;
+
+static double bench_raw(const std::vector<unsigned> &values) {
+  double start = get_time_s();
+  unsigned acc = 0;
+  for (unsigned v : values) {
+    acc += v * 2654435761u;
+  }
+  sink = acc;
+  return get_time_s() - start;
+}
+
+static double bench_view(const std::vector<unsigned> &values) {
+  double start = get_time_s();
+  unsigned acc = 0;
+  for (unsigned v : tqdm::view(values)) {
+    acc += v * 2654435761u;
+  }
+  sink = acc;
+  return get_time_s() - start;
+}
+
+int main(int argc, char **argv) {
+  int iterations = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+  if (iterations <= 0) {
+    fprintf(stderr, "iterations must be positive\n");
+    return 1;
+  }
+
+  std::vector<unsigned> values(static_cast<size_t>(iterations));
+  for (size_t i = 0; i < values.size(); i++)
+    values[i] = static_cast<unsigned>(i);
+
+  /* Warm up caches and the clock */
+  bench_raw(values);
+
+  double raw = bench_raw(values);
+  double view = bench_view(values);
+
+  printf("=== tqdm::view vs range-for (%d iterations) ===\n", iterations);
+  printf("range-for    : %8.3f s  %6.3f ns/iter\n", raw,
+         raw * 1e9 / iterations);
+  printf("tqdm::view   : %8.3f s  %6.3f ns/iter\n", view,
+         view * 1e9 / iterations);
+  printf("overhead     : %+8.3f ns/iter\n", (view - raw) * 1e9 / iterations);
+  return 0;
+}
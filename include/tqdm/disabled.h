@@ -0,0 +1,388 @@
+#ifndef TQDM_DISABLED_H
+#define TQDM_DISABLED_H
+
+/* Inline no-op API used when compiling with -DTQDM_DISABLE_ALL.
+ * Included by tqdm/tqdm.h only; do not include directly.
+ *
+ * Every call compiles to nothing. Functions that hand out a bar return a
+ * zeroed per-translation-unit dummy so "create failed" checks keep passing,
+ * and the iteration macros become plain for-loops. Note that the loop
+ * macros evaluate their bounds on every iteration in this mode.
+ *
+ * Bars that iterate (over an array, a total or an iterator) still do: they
+ * are heap bars holding only current/end/element_size or the iterator
+ * hooks, so hand-written tqdm_has_next/tqdm_next loops run unchanged and
+ * tqdm_destroy/tqdm_fini still call destroy_func. */
+
+#ifndef TQDM_H
+#error "include tqdm/tqdm.h instead of tqdm/disabled.h"
+#endif
+
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static inline tqdm_t *tqdm_disabled_bar_(void) {
+    static tqdm_t bar;
+    return &bar;
+}
+
+/* Iteration state only; pool_next pointing at the bar marks it as ours */
+static inline tqdm_t *tqdm_disabled_init_(tqdm_t *tqdm, void *begin,
+                                          void *end, size_t element_size,
+                                          size_t total) {
+    memset(tqdm, 0, sizeof(*tqdm));
+    tqdm->current = begin;
+    tqdm->end = end;
+    tqdm->element_size = element_size;
+    tqdm->params.total = total;
+    return tqdm;
+}
+static inline tqdm_t *tqdm_disabled_new_(void *begin, void *end,
+                                         size_t element_size, size_t total) {
+    void *mem;
+    if (!begin && !end && total == 0)
+        return tqdm_disabled_bar_();
+    if (posix_memalign(&mem, TQDM_CACHELINE, sizeof(tqdm_t)) != 0)
+        return NULL;
+    tqdm_t *tqdm =
+        tqdm_disabled_init_((tqdm_t *)mem, begin, end, element_size, total);
+    tqdm->pool_next = tqdm;
+    return tqdm;
+}
+static inline void tqdm_disabled_fini_(tqdm_t *tqdm) {
+    if (tqdm && tqdm->iterator_mode && tqdm->destroy_func)
+        tqdm->destroy_func(tqdm->iterator_state);
+}
+
+/* Core functions */
+static inline tqdm_t *tqdm_create(void *begin, void *end,
+                                  size_t element_size) {
+    return tqdm_disabled_new_(begin, end, element_size, 0);
+}
+static inline tqdm_t *tqdm_create_with_total(void *begin, size_t total,
+                                             size_t element_size) {
+    return tqdm_disabled_new_(begin, NULL, element_size, total);
+}
+static inline tqdm_t *tqdm_create_with_params(void *begin, void *end,
+                                              size_t element_size,
+                                              tqdm_params_t *params) {
+    return tqdm_disabled_new_(begin, end, element_size,
+                              params ? params->total : 0);
+}
+static inline tqdm_t *tqdm_create_iterator(void *iterator_state,
+                                           void *(*next_func)(void *),
+                                           bool (*has_next_func)(void *),
+                                           void (*destroy_func)(void *)) {
+    void *mem;
+    if (posix_memalign(&mem, TQDM_CACHELINE, sizeof(tqdm_t)) != 0)
+        return NULL;
+    tqdm_t *tqdm = tqdm_disabled_init_((tqdm_t *)mem, NULL, NULL, 0, 0);
+    tqdm->pool_next = tqdm;
+    tqdm->iterator_mode = true;
+    tqdm->iterator_state = iterator_state;
+    tqdm->next_func = next_func;
+    tqdm->has_next_func = has_next_func;
+    tqdm->destroy_func = destroy_func;
+    return tqdm;
+}
+static inline void tqdm_destroy(tqdm_t *tqdm) {
+    tqdm_disabled_fini_(tqdm);
+    if (tqdm && tqdm->pool_next == tqdm)
+        free(tqdm);
+}
+
+/* Caller-owned storage: only the iteration state is set */
+static inline tqdm_t *tqdm_init(tqdm_t *storage,
+                                const tqdm_params_t *params) {
+    if (!storage)
+        return NULL;
+    return tqdm_disabled_init_(storage, NULL, NULL, 0,
+                               params ? params->total : 0);
+}
+static inline tqdm_t *tqdm_init_with_total(tqdm_t *storage, void *begin,
+                                           size_t total,
+                                           size_t element_size) {
+    if (!storage)
+        return NULL;
+    return tqdm_disabled_init_(storage, begin, NULL, element_size, total);
+}
+static inline tqdm_t *tqdm_init_with_params(tqdm_t *storage, void *begin,
+                                            void *end, size_t element_size,
+                                            const tqdm_params_t *params) {
+    if (!storage)
+        return NULL;
+    return tqdm_disabled_init_(storage, begin, end, element_size,
+                               params ? params->total : 0);
+}
+static inline void tqdm_fini(tqdm_t *tqdm) { tqdm_disabled_fini_(tqdm); }
+
+/* Styles: a shared dummy, so NULL checks keep passing */
+static inline tqdm_style_t *tqdm_style_create(const tqdm_params_t *params) {
+    static char style;
+    (void)params;
+    return (tqdm_style_t *)&style;
+}
+static inline tqdm_style_t *tqdm_style_retain(tqdm_style_t *style) {
+    return style;
+}
+static inline void tqdm_style_release(tqdm_style_t *style) { (void)style; }
+static inline tqdm_t *tqdm_create_with_style(tqdm_style_t *style,
+                                             const char *desc, size_t total) {
+    (void)style; (void)desc; (void)total;
+    return tqdm_disabled_bar_();
+}
+static inline tqdm_t *tqdm_init_with_style(tqdm_t *storage,
+                                           tqdm_style_t *style,
+                                           const char *desc, size_t total) {
+    (void)style; (void)desc;
+    if (!storage)
+        return NULL;
+    return tqdm_disabled_init_(storage, NULL, NULL, 0, total);
+}
+static inline size_t tqdm_style_render(const tqdm_style_t *style,
+                                       const tqdm_frame_t *frame, char *buf,
+                                       size_t size) {
+    (void)style; (void)frame;
+    if (size > 0)
+        buf[0] = '\0';
+    return 0;
+}
+
+/* Dashboard groups */
+static inline tqdm_group_t *tqdm_group_create(const tqdm_params_t *params,
+                                              size_t rows,
+                                              tqdm_group_order_t order,
+                                              double stall_after) {
+    static char group;
+    (void)params; (void)rows; (void)order; (void)stall_after;
+    return (tqdm_group_t *)&group;
+}
+static inline bool tqdm_group_add(tqdm_group_t *group, tqdm_t *tqdm) {
+    (void)group; (void)tqdm;
+    return true;
+}
+static inline void tqdm_group_remove(tqdm_group_t *group, tqdm_t *tqdm) {
+    (void)group; (void)tqdm;
+}
+static inline void tqdm_group_refresh(tqdm_group_t *group) { (void)group; }
+static inline void tqdm_group_close(tqdm_group_t *group) { (void)group; }
+static inline void tqdm_group_destroy(tqdm_group_t *group) { (void)group; }
+
+static inline void tqdm_pool_trim(void) {}
+
+/* Iterator: same bounds as the real bar, minus the bar */
+static inline bool tqdm_has_next(tqdm_t *tqdm) {
+    if (tqdm->iterator_mode)
+        return tqdm->has_next_func(tqdm->iterator_state);
+    if (tqdm->end)
+        return (char *)tqdm->current < (char *)tqdm->end;
+    if (tqdm->params.total > 0)
+        return tqdm->n < tqdm->params.total;
+    return true;
+}
+static inline void *tqdm_next(tqdm_t *tqdm) {
+    if (!tqdm_has_next(tqdm))
+        return NULL;
+    if (tqdm->iterator_mode)
+        return tqdm->next_func(tqdm->iterator_state);
+    if (!tqdm->end && tqdm->params.total == 0)
+        return tqdm->current; /* Unbounded: nothing to advance */
+    void *result = tqdm->current;
+    if (result)
+        tqdm->current = (char *)result + tqdm->element_size;
+    tqdm->n++;
+    return result;
+}
+static inline tqdm_t *tqdm_iter(tqdm_t *tqdm) { return tqdm; }
+
+/* Update */
+static inline void tqdm_update(tqdm_t *tqdm) { (void)tqdm; }
+static inline void tqdm_update_n(tqdm_t *tqdm, size_t n) {
+    (void)tqdm; (void)n;
+}
+static inline bool tqdm_update_to(tqdm_t *tqdm, size_t n) {
+    (void)tqdm; (void)n;
+    return false;
+}
+static inline void tqdm_update_weighted(tqdm_t *tqdm, size_t items,
+                                        size_t cost) {
+    (void)tqdm; (void)items; (void)cost;
+}
+static inline void tqdm_update_dynamic_miniters(tqdm_t *tqdm) { (void)tqdm; }
+static inline void tqdm_add_total(tqdm_t *tqdm, size_t delta) {
+    (void)tqdm; (void)delta;
+}
+static inline void tqdm_phase_begin(tqdm_t *tqdm, const char *name,
+                                    double expected_fraction) {
+    (void)tqdm; (void)name; (void)expected_fraction;
+}
+
+/* tqdm functions */
+static inline void tqdm_close(tqdm_t *tqdm) { (void)tqdm; }
+static inline void tqdm_clear(tqdm_t *tqdm) { (void)tqdm; }
+static inline void tqdm_refresh(tqdm_t *tqdm) { (void)tqdm; }
+static inline void tqdm_unpause(tqdm_t *tqdm) { (void)tqdm; }
+static inline void tqdm_reset(tqdm_t *tqdm, size_t total) {
+    (void)tqdm; (void)total;
+}
+static inline void tqdm_set_description(tqdm_t *tqdm, const char *desc) {
+    (void)tqdm; (void)desc;
+}
+static inline void tqdm_set_description_str(tqdm_t *tqdm, const char *desc,
+                                            bool refresh) {
+    (void)tqdm; (void)desc; (void)refresh;
+}
+static inline void tqdm_set_postfix(tqdm_t *tqdm, postfix_entry_t *postfix) {
+    (void)tqdm; (void)postfix;
+}
+static inline void tqdm_set_postfix_str(tqdm_t *tqdm, const char *postfix,
+                                        bool refresh) {
+    (void)tqdm; (void)postfix; (void)refresh;
+}
+/* Messages are user output, so they are still printed (without locking) */
+static inline void tqdm_write(const char *s, FILE *file, const char *end,
+                              bool nolock) {
+    (void)nolock;
+    fputs(s, file ? file : stdout);
+    fputs(end ? end : "\n", file ? file : stdout);
+}
+static inline void tqdm_display(tqdm_t *tqdm, const char *msg, int pos) {
+    (void)tqdm; (void)msg; (void)pos;
+}
+static inline tqdm_format_dict_t *tqdm_format_dict(tqdm_t *tqdm) {
+    static tqdm_format_dict_t dict;
+    (void)tqdm;
+    return &dict;
+}
+
+/* Global lock */
+static inline void tqdm_set_lock(pthread_mutex_t *lock) { (void)lock; }
+static inline pthread_mutex_t *tqdm_get_lock(void) {
+    static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    return &lock;
+}
+
+/* Context managers: real contexts, so callers can use their fields; the
+ * wrapped stream is passed straight through */
+static inline tqdm_external_write_context_t *
+tqdm_external_write_mode(FILE *file, bool nolock) {
+    tqdm_external_write_context_t *ctx =
+        (tqdm_external_write_context_t *)calloc(1, sizeof(*ctx));
+    (void)nolock;
+    if (ctx)
+        ctx->original_file = file ? file : stdout;
+    return ctx;
+}
+static inline void
+tqdm_external_write_mode_exit(tqdm_external_write_context_t *ctx) {
+    free(ctx);
+}
+static inline tqdm_wrapattr_context_t *
+tqdm_wrapattr(FILE *stream, const char *method, size_t total, bool bytes,
+              tqdm_params_t *params) {
+    tqdm_wrapattr_context_t *ctx =
+        (tqdm_wrapattr_context_t *)calloc(1, sizeof(*ctx));
+    (void)total; (void)bytes; (void)params;
+    if (!ctx)
+        return NULL;
+    ctx->tqdm = tqdm_disabled_bar_();
+    ctx->stream = stream;
+    ctx->method = method;
+    ctx->read_func = fread;
+    ctx->write_func = fwrite;
+    return ctx;
+}
+static inline void tqdm_wrapattr_exit(tqdm_wrapattr_context_t *ctx) {
+    free(ctx);
+}
+
+/* The copy still happens, without a bar: a plain read/write loop */
+static inline ssize_t tqdm_copy_fd(int in_fd, int out_fd, size_t len,
+                                   const tqdm_params_t *params) {
+    char buf[65536];
+    size_t copied = 0;
+    (void)params;
+    while (len == 0 || copied < len) {
+        size_t want = sizeof(buf);
+        if (len > 0 && len - copied < want)
+            want = len - copied;
+        ssize_t got = read(in_fd, buf, want);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            return got < 0 ? -1 : (ssize_t)copied;
+        for (ssize_t put = 0; put < got;) {
+            ssize_t w = write(out_fd, buf + put, (size_t)(got - put));
+            if (w < 0 && errno == EINTR)
+                continue;
+            if (w < 0)
+                return -1;
+            put += w;
+        }
+        copied += (size_t)got;
+    }
+    return (ssize_t)copied;
+}
+
+/* Monitor thread */
+static inline void tqdm_start_monitor(tqdm_t *tqdm) { (void)tqdm; }
+static inline void tqdm_stop_monitor(tqdm_t *tqdm) { (void)tqdm; }
+static inline void *tqdm_monitor_thread(void *arg) {
+    (void)arg;
+    return NULL;
+}
+
+/* Pandas integration stub */
+static inline void tqdm_pandas_register(tqdm_params_t *params) {
+    (void)params;
+}
+
+/* Range loops */
+static inline tqdm_range_loop_t *
+tqdm_range_loop_init(tqdm_range_loop_t *loop, int start, int end, int step) {
+    range_init(&loop->range, start, end, step);
+    return loop;
+}
+static inline tqdm_range_loop_t *
+tqdm_loop_init(tqdm_range_loop_t *loop, size_t total,
+               const tqdm_params_t *params) {
+    (void)total; (void)params;
+    return loop;
+}
+static inline void tqdm_range_loop_tick(tqdm_range_loop_t *loop) {
+    (void)loop;
+}
+static inline void tqdm_range_loop_fini(tqdm_range_loop_t *loop) {
+    (void)loop;
+}
+static inline bool tqdm_range_loop_has_next(const tqdm_range_loop_t *loop) {
+    return loop->range.step > 0 ? loop->range.current < loop->range.total
+                                : loop->range.current > loop->range.total;
+}
+static inline void tqdm_range_loop_advance(tqdm_range_loop_t *loop) {
+    loop->range.current += loop->range.step;
+}
+
+/* Plain loops */
+#define TQDM_FOR(type, var, start, end) \
+    for (type var = (start); var < (end); ++var)
+
+#define TQDM_FOR_STEP(type, var, start, end, step) \
+    for (type var = (start); (step) > 0 ? var < (end) : var > (end); \
+         var += (step))
+
+/* Steps an element of the array at a time whatever type is, as the real
+ * macro does */
+#define TQDM_FOR_ARRAY(type, var, array, size) \
+    for (type var = (type)(array); \
+         (const char *)(var) < (const char *)((array) + (size)); \
+         var = (type)((const char *)(var) + sizeof(*(array))))
+
+#define TQDM_MANUAL(var, total) \
+    for (tqdm_t *var = tqdm_disabled_bar_(), *_once_##var = var; \
+         _once_##var; _once_##var = NULL)
+
+#define TQDM_UPDATE(pbar) ((void)(pbar))
+
+#endif /* TQDM_DISABLED_H */
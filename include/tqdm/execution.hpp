@@ -0,0 +1,167 @@
+#ifndef TQDM_EXECUTION_HPP
+#define TQDM_EXECUTION_HPP
+
+/* tqdm::for_each and tqdm::transform_reduce: the standard parallel
+ * algorithms, taking the same execution policies, with a bar over the
+ * elements done across all threads. Kept apart from tqdm.hpp because
+ * <execution> can tie its includers to a parallel runtime (TBB under
+ * libstdc++). */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <execution>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <utility>
+
+#include "tqdm/tqdm.hpp"
+
+namespace tqdm {
+
+#if defined(__cpp_lib_execution)
+namespace detail {
+
+/* Progress from the threads of a parallel algorithm. Each thread counts
+ * into its own shard of a policy::sharded_counter, so an element costs one
+ * uncontended atomic add rather than the bar's mutex; a merger thread
+ * sums the shards into the bar every mininterval. */
+class merged_progress {
+public:
+  explicit merged_progress(tqdm_t *bar) : bar_(bar) {
+    if (bar_)
+      merger_ = std::thread([this] { merge(); });
+  }
+  ~merged_progress() { finish(); }
+
+  merged_progress(const merged_progress &) = delete;
+  merged_progress &operator=(const merged_progress &) = delete;
+
+  void add() noexcept { counter_.add(1); }
+
+  /* Stop the merger and credit the final count */
+  void finish() {
+    if (!merger_.joinable())
+      return;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_ = true;
+    }
+    cv_.notify_one();
+    merger_.join();
+    tqdm_update_to(bar_, counter_.load());
+  }
+
+private:
+  void merge() {
+    float mininterval = bar_->params.mininterval;
+    std::chrono::duration<double> interval(
+        mininterval > 0.01f ? mininterval : 0.01f);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!cv_.wait_for(lock, interval, [this] { return done_; }))
+      tqdm_update_to(bar_, counter_.load());
+  }
+
+  tqdm_t *bar_;
+  policy::sharded_counter counter_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool done_ = false;
+  std::thread merger_;
+};
+
+/* A bar for an algorithm over total elements */
+inline bar algorithm_bar(std::size_t total, const tqdm_params_t *params,
+                         const char *desc) {
+  if (!params)
+    return bar(total, desc);
+  tqdm_params_t p = *params;
+  if (total > 0)
+    p.total = total;
+  return bar(p);
+}
+
+template <class Policy, class It, class F>
+void for_each(Policy &&policy, It first, It last, F f,
+              const tqdm_params_t *params, const char *desc) {
+  if constexpr (!enabled) {
+    std::for_each(std::forward<Policy>(policy), first, last, std::move(f));
+  } else {
+    bar b = algorithm_bar(
+        static_cast<std::size_t>(std::distance(first, last)), params, desc);
+    merged_progress progress(b.get());
+    std::for_each(std::forward<Policy>(policy), first, last,
+                  [&f, &progress](auto &&x) {
+                    f(std::forward<decltype(x)>(x));
+                    progress.add();
+                  });
+    progress.finish();
+  }
+}
+
+template <class Policy, class It, class T, class Reduce, class Transform>
+T transform_reduce(Policy &&policy, It first, It last, T init,
+                   Reduce reduce, Transform transform,
+                   const tqdm_params_t *params, const char *desc) {
+  if constexpr (!enabled) {
+    return std::transform_reduce(std::forward<Policy>(policy), first, last,
+                                 std::move(init), std::move(reduce),
+                                 std::move(transform));
+  } else {
+    bar b = algorithm_bar(
+        static_cast<std::size_t>(std::distance(first, last)), params, desc);
+    merged_progress progress(b.get());
+    T result = std::transform_reduce(
+        std::forward<Policy>(policy), first, last, std::move(init),
+        std::move(reduce),
+        [&transform, &progress](auto &&x) -> decltype(auto) {
+          progress.add();
+          return transform(std::forward<decltype(x)>(x));
+        });
+    progress.finish();
+    return result;
+  }
+}
+
+} // namespace detail
+
+/* std::for_each(policy, first, last, f) with a bar over its elements */
+template <class Policy, class It, class F>
+void for_each(Policy &&policy, It first, It last, F f,
+              const tqdm_params_t &params) {
+  detail::for_each(std::forward<Policy>(policy), first, last, std::move(f),
+                   &params, nullptr);
+}
+
+template <class Policy, class It, class F>
+void for_each(Policy &&policy, It first, It last, F f,
+              const char *desc = nullptr) {
+  detail::for_each(std::forward<Policy>(policy), first, last, std::move(f),
+                   nullptr, desc);
+}
+
+/* std::transform_reduce(policy, first, last, init, reduce, transform), an
+ * element counted as it is transformed */
+template <class Policy, class It, class T, class Reduce, class Transform>
+T transform_reduce(Policy &&policy, It first, It last, T init, Reduce reduce,
+                   Transform transform, const tqdm_params_t &params) {
+  return detail::transform_reduce(std::forward<Policy>(policy), first, last,
+                                  std::move(init), std::move(reduce),
+                                  std::move(transform), &params, nullptr);
+}
+
+template <class Policy, class It, class T, class Reduce, class Transform>
+T transform_reduce(Policy &&policy, It first, It last, T init, Reduce reduce,
+                   Transform transform, const char *desc = nullptr) {
+  return detail::transform_reduce(std::forward<Policy>(policy), first, last,
+                                  std::move(init), std::move(reduce),
+                                  std::move(transform), nullptr, desc);
+}
+#endif /* __cpp_lib_execution */
+
+} // namespace tqdm
+
+#endif /* TQDM_EXECUTION_HPP */
@@ -11,6 +11,7 @@
 #include <string.h>
 #include <stdbool.h>
 #include <pthread.h>
+#include <sys/types.h>
 
 #include "tqdm/utils.h"
 
@@ -24,6 +25,8 @@ extern "C" {
 
 typedef struct tqdm_s tqdm_t;
 typedef struct tqdm_params_s tqdm_params_t;
+typedef struct tqdm_style_s tqdm_style_t;
+typedef struct tqdm_group_s tqdm_group_t;
 
 /* Format dictionary structure */
 typedef struct {
@@ -54,6 +57,19 @@ typedef struct {
     char *r_bar;              /* Right bar part */
 } tqdm_format_dict_t;
 
+/* One frame's values, for drawing progress counted outside a tqdm_t (as
+ * tqdm::basic_bar in tqdm.hpp does) with a style's look */
+typedef struct {
+    size_t n;
+    size_t total;             /* 0 when unknown */
+    double elapsed;           /* Seconds */
+    double rate;              /* Units per second, <= 0 when unknown */
+    double remaining;         /* Seconds, < 0 when unknown */
+    const char *desc;         /* Or NULL */
+    const char *postfix;      /* Or NULL */
+    int ncols;                /* <= 0: the terminal's width */
+} tqdm_frame_t;
+
 /* Postfix dictionary entry */
 typedef struct postfix_entry_s {
     char *key;
@@ -96,6 +112,49 @@ typedef struct {
     bool cache_valid;
 } tqdm_cache_t;
 
+/* Rate estimators. reset() is called when a bar starts, sample() with
+ * (seconds since start, count) on each refresh, and rate() gives units per
+ * second for the rate and ETA fields, <= 0 while unknown (the lifetime
+ * average is shown then). State lives inside the bar, so an estimator
+ * never allocates; custom ones must fit TQDM_ESTIMATOR_STATE_SIZE. */
+#define TQDM_ESTIMATOR_STATE_SIZE 384
+
+typedef union {
+    double align;
+    unsigned char bytes[TQDM_ESTIMATOR_STATE_SIZE];
+} tqdm_estimator_state_t;
+
+typedef struct tqdm_estimator_s {
+    const char *name;
+    void (*reset)(tqdm_estimator_state_t *state, const tqdm_params_t *params);
+    void (*sample)(tqdm_estimator_state_t *state, double t, double n);
+    double (*rate)(const tqdm_estimator_state_t *state);
+} tqdm_estimator_t;
+
+extern const tqdm_estimator_t tqdm_estimator_avg;    /* Lifetime average */
+extern const tqdm_estimator_t tqdm_estimator_ema;    /* Python tqdm's EMA */
+extern const tqdm_estimator_t tqdm_estimator_linreg; /* Weighted least
+                                                      * squares (default) */
+
+/* params.smoothing value asking the EMA to tune its coefficient from how
+ * much the per-interval rate varies (TQDM_SMOOTHING=auto). Bars without an
+ * explicit estimator use the EMA then. */
+#define TQDM_SMOOTHING_AUTO (-1.0f)
+
+/* Built-in estimator by name ("avg", "ema", "linreg"), or NULL */
+const tqdm_estimator_t *tqdm_estimator_find(const char *name);
+
+/* Things the monitor thread and the rate model report about a bar
+ * through params.on_event. Callbacks run on the monitor thread with no
+ * tqdm locks held, so they may close, refresh or destroy the bar. */
+typedef enum {
+    TQDM_EVENT_STALLED,       /* No progress for params.stall_timeout */
+    TQDM_EVENT_RESUMED,       /* A stalled bar moved again */
+    TQDM_EVENT_RATE_CHANGE    /* Throughput shifted; the rate model restarted */
+} tqdm_event_t;
+
+typedef void (*tqdm_event_fn)(tqdm_t *tqdm, tqdm_event_t event, void *data);
+
 /* Core parameters */
 struct tqdm_params_s {
     char *desc;               /* Description prefix */
@@ -110,52 +169,176 @@ struct tqdm_params_s {
     char *unit;               /* Unit of measurement */
     bool unit_scale;          /* Auto-scale units */
     bool dynamic_ncols;       /* Dynamic column width */
-    float smoothing;          /* Rate smoothing factor */
+    float smoothing;          /* Rate smoothing factor, or
+                               * TQDM_SMOOTHING_AUTO */
     char *bar_format;         /* Custom bar format */
     size_t initial;           /* Initial counter value */
     int position;             /* Line position for multiple bars */
     char *postfix;            /* Postfix string */
     float unit_divisor;       /* Unit divisor (1000 or 1024) */
     char *colour;             /* Progress bar colour */
-    float delay;              /* Initial delay before showing */
+    float delay;              /* Seconds before the bar is first drawn */
+    const tqdm_estimator_t *estimator; /* Rate model; NULL for linreg */
+    size_t cost_total;        /* Summed item weights; 0 when unknown */
+    char *history_file;       /* Past runs' ETA profiles; NULL for none */
+    float stall_timeout;      /* Seconds without progress to stall; 0 off */
+    tqdm_event_fn on_event;   /* Called on stalls and rate changes (from
+                               * the monitor thread); NULL for none */
+    void *on_event_data;      /* Passed to on_event */
 };
 
-/* tqdm data*/
+/* Slots for the strings a bar owns (buffers are recycled by the pool) */
+enum {
+    TQDM_STR_DESC,
+    TQDM_STR_UNIT,
+    TQDM_STR_BAR_FORMAT,
+    TQDM_STR_COLOUR,
+    TQDM_STR_POSTFIX,
+    TQDM_STR_HISTORY_FILE,
+    TQDM_STR_PHASE,
+    TQDM_STR_COUNT
+};
+
+/* Bars kept per thread for reuse by tqdm_create_* */
+#define TQDM_POOL_MAX 16
+
+/* Inline storage for short strings; longer ones spill to the heap */
+#define TQDM_INLINE_STR_SIZE 128
+#define TQDM_RATE_HISTORY_SIZE 10
+
+/* Streaming quantile of the per-interval rates (P^2 algorithm): five
+ * markers, so constant memory however long the run */
+typedef struct {
+    double p;                 /* Quantile tracked, 0..1 */
+    double q[5];              /* Marker heights; sorted samples until 5 */
+    double pos[5];            /* Marker positions, 1-based */
+    double want[5];           /* Desired positions */
+    size_t count;
+} tqdm_quantile_t;
+
+/* Page-Hinkley test for a shift in the per-interval rate, in units of the
+ * current regime's spread (Welford mean and variance) */
+typedef struct {
+    size_t count;             /* Intervals in the current regime */
+    double mean;
+    double m2;                /* Sum of squared deviations */
+    double up;                /* Evidence of a rise, >= 0 */
+    double down;              /* Evidence of a drop, >= 0 */
+} tqdm_change_t;
+
+/* Rate quantiles bounding {eta_range} */
+#define TQDM_ETA_RANGE_LOW 0.1
+#define TQDM_ETA_RANGE_HIGH 0.9
+
+/* Run history profile: seconds elapsed at 0%, 10%, ..., 100% */
+#define TQDM_HISTORY_MARKS 11
+
+/* Per-run state of a bar with a history_file */
+typedef struct {
+    uint64_t key;                    /* Hash of desc and totals */
+    float prior[TQDM_HISTORY_MARKS]; /* From previous runs */
+    float marks[TQDM_HISTORY_MARKS]; /* This run so far */
+    size_t next;                     /* Marks recorded */
+    double last_t;                   /* Previous sample, to interpolate */
+    double last_f;
+    bool prior_valid;
+} tqdm_history_run_t;
+
+/* The rate quantiles behind {eta_range} */
+typedef struct {
+    tqdm_quantile_t low;
+    tqdm_quantile_t high;
+} tqdm_rate_range_t;
+
+/* Cache line size assumed by the tqdm_t layout */
+#define TQDM_CACHELINE 64
+
+#if defined(_MSC_VER)
+#define TQDM_ALIGNED(n) __declspec(align(n))
+#else
+#define TQDM_ALIGNED(n) __attribute__((aligned(n)))
+#endif
+
+/* tqdm data. Fields are grouped by who writes them so that updates from
+ * one thread do not false-share with readers of the config or with the
+ * renderer: each group starts on its own cache line. The layout is checked
+ * by static asserts in tqdm.c. State only some bars need (a growing
+ * total, {eta_range}, run history) is allocated when a bar uses it, and
+ * frames are rendered on the stack. */
 struct tqdm_s {
-    void *current;
-    void *end;
-    size_t element_size;
-    size_t n;                 /* Current value */
+    /* Writer-hot: touched by every update/next. n and cost are written
+     * atomically under lock, so monitors and dashboards may read them
+     * without it */
+    TQDM_ALIGNED(TQDM_CACHELINE) size_t n; /* Current value */
+    size_t cost;              /* Summed weights of the items in n */
     size_t count;             /* Total count */
-    
-    tqdm_params_t params;
-    
-    double start_time;
-    double last_print_time;
+    void *current;
+    pthread_mutex_t lock;
+
+    /* Render state: written at most once per refresh */
+    TQDM_ALIGNED(TQDM_CACHELINE) double last_print_time;
     size_t last_print_count;
-    bool closed;
-    bool paused;
+    double last_progress_time; /* Last refresh that saw n move */
+    double start_time;
     double pause_start;
     double total_pause_time;
-    
-    double *rate_history;     /* Rate history for smoothing */
-    size_t rate_history_size;
-    size_t rate_history_idx;
-    double cached_rate;
-    double last_rate_calc_time;
-    size_t last_rate_calc_n;
-    
+    bool closed;
+    bool paused;
+    bool displayed;           /* Drawn at least once (past the delay) */
+    bool muted;               /* Output is /dev/null or gone: count only */
+    bool weighted;            /* Bar, rate and ETA follow cost, not n */
+    bool growing;             /* Total raised by tqdm_add_total */
     int cached_terminal_width;
     double last_terminal_check;
-    char display_buffer[1024]; /* Display buffer */
-    
-    pthread_mutex_t lock;
-    
+    double cached_rate;       /* Estimator's rate at the last refresh */
+    double cached_discovery_rate; /* Growth of a growing total, per second */
+    double last_rate_calc_time; /* Start of the current rate sample */
+    size_t last_rate_calc_n;
+    size_t rate_origin_n;     /* Estimator's zero: progress and elapsed */
+    double rate_origin_time;  /* seconds at the phase start or rate change */
+    size_t phase_end_n;       /* Where the phase should end; 0 = the end */
+    bool phased;              /* tqdm_phase_begin has been called */
+    size_t rate_history_idx;  /* Samples pushed into rate_history */
+
+    /* Read-mostly config */
+    TQDM_ALIGNED(TQDM_CACHELINE) tqdm_params_t params;
+    void *end;
+    size_t element_size;
     bool iterator_mode;
     void *iterator_state;
     void *(*next_func)(void *state);
     bool (*has_next_func)(void *state);
     void (*destroy_func)(void *state);
+    tqdm_style_t *style;      /* Shared style, or NULL to render from params */
+    tqdm_group_t *group;      /* Dashboard drawing this bar, or NULL */
+
+    /* Cold: strings and buffers, kept out of the lines above */
+    TQDM_ALIGNED(TQDM_CACHELINE) double
+        rate_history[TQDM_RATE_HISTORY_SIZE]; /* Ring of recent rates */
+    size_t rate_history_size;
+    tqdm_rate_range_t *rate_range;   /* Same rates, per phase, when the
+                                      * format shows {eta_range} */
+    tqdm_change_t rate_change;       /* Same rates: regime shifts */
+    char *str_buf[TQDM_STR_COUNT];   /* Owned string buffers */
+    size_t str_cap[TQDM_STR_COUNT];  /* Capacity of each buffer */
+    char str_inline[TQDM_INLINE_STR_SIZE]; /* Arena for short strings */
+    size_t str_inline_used;
+    tqdm_t *pool_next;               /* Freelist link while pooled */
+    tqdm_estimator_state_t estimator_state;
+    tqdm_estimator_state_t *discovery_state; /* Fed the total's growth,
+                                              * once it grows */
+    size_t base_total;               /* Total before any tqdm_add_total */
+    char *phase_name;                /* Current phase, or NULL */
+    tqdm_history_run_t *history;     /* With a history_file only */
+
+    /* Written by the monitor thread only */
+    tqdm_t *monitor_next;            /* Monitored bars list link */
+    size_t monitor_n;                /* n at the last scan */
+    double monitor_progress_time;    /* When the monitor last saw n move */
+    bool monitored;
+    bool stalled;
+    bool rate_changed;               /* Set by the renderer, reported and
+                                      * cleared by the monitor */
 };
 
 typedef struct {
@@ -164,9 +347,99 @@ typedef struct {
     int step;
 } range_iterator_t;
 
+/* Loop state behind TQDM_FOR / TQDM_FOR_STEP, kept on the caller's stack.
+ * The bar is only touched every `stride` iterations. */
+typedef struct {
+    tqdm_t bar;
+    range_iterator_t range;
+    size_t countdown;         /* Iterations left before the next update */
+    size_t stride;            /* Iterations credited per update */
+    double last_tick;         /* Time of the last update */
+    bool active;              /* Bar was initialised */
+} tqdm_range_loop_t;
+
+/* Which member bars a dashboard group shows */
+typedef enum {
+    TQDM_GROUP_SLOWEST,       /* Longest estimated time to finish first */
+    TQDM_GROUP_RECENT         /* Most recent progress first */
+} tqdm_group_order_t;
+
 /* Global lock */
 extern pthread_mutex_t *tqdm_global_lock;
 
+/* Context managers for external write mode and file wrapper */
+typedef struct {
+    tqdm_t *tqdm;
+    FILE *original_file;
+    bool lock_acquired;
+} tqdm_external_write_context_t;
+
+/* File wrapper context manager for file operations */
+typedef struct {
+    tqdm_t *tqdm;
+    FILE *stream;
+    const char *method;
+    size_t (*read_func)(void *ptr, size_t size, size_t nmemb, FILE *stream);
+    size_t (*write_func)(const void *ptr, size_t size, size_t nmemb, FILE *stream);
+} tqdm_wrapattr_context_t;
+
+/* Unicode block characters for progress bar */
+extern const char *tqdm_unicode_blocks[];
+extern const char *tqdm_ascii_blocks;
+
+/* Format functions */
+char *tqdm_format_sizeof(double num, const char *suffix, int divisor);
+char *tqdm_format_interval(double t);
+char *tqdm_format_num(double n);
+char *tqdm_format_meter(size_t n, size_t total, double elapsed, 
+                       int ncols, const char *prefix, bool ascii,
+                       const char *unit, bool unit_scale, double rate,
+                       const char *bar_format, const char *postfix,
+                       int unit_divisor, size_t initial, const char *colour);
+
+/* Output nobody sees: /dev/null or a closed fd. Bars writing there count
+ * but never draw. */
+bool tqdm_output_discarded(FILE *file);
+
+/* Range */
+range_iterator_t *range_create(int n);
+range_iterator_t *range_create_with_bounds(int start, int end);
+range_iterator_t *range_create_with_step(int start, int end, int step);
+void range_destroy(range_iterator_t *range);
+void range_init(range_iterator_t *range, int start, int end, int step);
+
+bool range_has_next(range_iterator_t *range);
+int range_next(range_iterator_t *range);
+
+/* Convenience functions for a more similar API to Python tqdm */
+range_iterator_t *trange(int n);
+range_iterator_t *trange_with_bounds(int start, int end);
+range_iterator_t *trange_with_step(int start, int end, int step);
+
+/* Helper functions for tqdm parameters */
+tqdm_params_t tqdm_default_params(void);
+void tqdm_cleanup_params(tqdm_params_t *params);
+
+/* Environment variables. TQDM_* is parsed once per process and applied
+ * to default params; call tqdm_reload_env() after changing it at runtime. */
+void tqdm_load_env_vars(tqdm_params_t *params);
+void tqdm_reload_env(void);
+
+/* Postfix dictionary */
+postfix_entry_t *postfix_create(void);
+void postfix_add(postfix_entry_t **head, const char *key, const char *value);
+void postfix_add_int(postfix_entry_t **head, const char *key, int value);
+void postfix_add_float(postfix_entry_t **head, const char *key, double value);
+char *postfix_format(postfix_entry_t *head);
+void postfix_destroy(postfix_entry_t *head);
+
+/* Building with -DTQDM_DISABLE_ALL swaps everything below for inline no-ops
+ * (and the TQDM_FOR* macros for plain loops) so the compiler can erase it.
+ * The helpers above stay real: callers own the memory they return. */
+#if defined(TQDM_DISABLE_ALL) && !defined(TQDM_BUILDING_LIBRARY)
+#include "tqdm/disabled.h"
+#else
+
 /* Core functions */
 tqdm_t *tqdm_create(void *begin, void *end, size_t element_size);
 tqdm_t *tqdm_create_with_total(void *begin, size_t total, size_t element_size);
@@ -177,6 +450,83 @@ tqdm_t *tqdm_create_iterator(void *iterator_state,
                             void (*destroy_func)(void *));
 void tqdm_destroy(tqdm_t *tqdm);
 
+/* Caller-owned storage (stack, or embedded in another struct). A NULL
+ * params pointer means defaults; tqdm_fini releases without freeing. */
+tqdm_t *tqdm_init(tqdm_t *storage, const tqdm_params_t *params);
+tqdm_t *tqdm_init_with_total(tqdm_t *storage, void *begin, size_t total,
+                             size_t element_size);
+tqdm_t *tqdm_init_with_params(tqdm_t *storage, void *begin, void *end,
+                              size_t element_size,
+                              const tqdm_params_t *params);
+void tqdm_fini(tqdm_t *tqdm);
+
+/* Shared styles: an immutable, refcounted look (unit, compiled bar_format,
+ * glyphs, colour) built once from params. Bars made from a style reference
+ * its strings instead of copying them and keep it alive until destroyed.
+ * tqdm_style_create returns NULL (errno EINVAL) on a bad bar_format. */
+tqdm_style_t *tqdm_style_create(const tqdm_params_t *params);
+tqdm_style_t *tqdm_style_retain(tqdm_style_t *style);
+void tqdm_style_release(tqdm_style_t *style);
+tqdm_t *tqdm_create_with_style(tqdm_style_t *style, const char *desc,
+                               size_t total);
+tqdm_t *tqdm_init_with_style(tqdm_t *storage, tqdm_style_t *style,
+                             const char *desc, size_t total);
+/* Render a frame in a style into buf without allocating; returns the
+ * length (snprintf semantics, truncated to size) */
+size_t tqdm_style_render(const tqdm_style_t *style, const tqdm_frame_t *frame,
+                         char *buf, size_t size);
+
+/* The bar_format fields, as X(name, ID, type) with type 's' string, 'f'
+ * real, 'd' integer or 'b' the bar; and the most pieces (fields and
+ * literal runs) one format may have. The format compiler and tqdm.hpp's
+ * compile-time check are both built from these. */
+#define TQDM_FORMAT_FIELDS(X)                                                 \
+    X(l_bar, L_BAR, 's')                                                      \
+    X(bar, BAR, 'b')                                                          \
+    X(r_bar, R_BAR, 's')                                                      \
+    X(desc, DESC, 's')                                                        \
+    X(percentage, PERCENTAGE, 'f')                                            \
+    X(n, N, 'd')                                                              \
+    X(n_fmt, N_FMT, 's')                                                      \
+    X(total, TOTAL, 'd')                                                      \
+    X(total_fmt, TOTAL_FMT, 's')                                              \
+    X(elapsed, ELAPSED, 's')                                                  \
+    X(elapsed_s, ELAPSED_S, 'f')                                              \
+    X(remaining, REMAINING, 's')                                              \
+    X(remaining_s, REMAINING_S, 'f')                                          \
+    X(rate, RATE, 'f')                                                        \
+    X(rate_fmt, RATE_FMT, 's')                                                \
+    X(rate_noinv, RATE_NOINV, 'f')                                            \
+    X(rate_noinv_fmt, RATE_NOINV_FMT, 's')                                    \
+    X(rate_inv, RATE_INV, 'f')                                                \
+    X(rate_inv_fmt, RATE_INV_FMT, 's')                                        \
+    X(unit, UNIT, 's')                                                        \
+    X(postfix, POSTFIX, 's')                                                  \
+    X(items, ITEMS, 'd')                                                      \
+    X(items_total, ITEMS_TOTAL, 'd')                                          \
+    X(total_est, TOTAL_EST, 'd')                                              \
+    X(sparkline, SPARKLINE, 's')                                              \
+    X(phase, PHASE, 's')                                                      \
+    X(eta_range, ETA_RANGE, 's')
+#define TQDM_FORMAT_MAX_TOKENS 32
+
+/* Dashboard groups: many bars drawn as a fixed block of rows, namely an
+ * aggregate bar (with done/active/stalled counts) followed by `rows` member
+ * bars, either the furthest from done or the most recently active. Bars in
+ * a group never draw themselves; each frame formats only the visible rows.
+ * A bar that has not advanced for stall_after seconds counts as stalled.
+ * Destroying a member removes it; destroy the group after its members. */
+tqdm_group_t *tqdm_group_create(const tqdm_params_t *params, size_t rows,
+                                tqdm_group_order_t order, double stall_after);
+bool tqdm_group_add(tqdm_group_t *group, tqdm_t *tqdm);
+void tqdm_group_remove(tqdm_group_t *group, tqdm_t *tqdm);
+void tqdm_group_refresh(tqdm_group_t *group);
+void tqdm_group_close(tqdm_group_t *group);
+void tqdm_group_destroy(tqdm_group_t *group);
+
+/* Object pool: release the calling thread's cached bars */
+void tqdm_pool_trim(void);
+
 /* Iterator */
 bool tqdm_has_next(tqdm_t *tqdm);
 void *tqdm_next(tqdm_t *tqdm);
@@ -186,6 +536,26 @@ tqdm_t *tqdm_iter(tqdm_t *tqdm);
 void tqdm_update(tqdm_t *tqdm);
 void tqdm_update_n(tqdm_t *tqdm, size_t n);
 bool tqdm_update_to(tqdm_t *tqdm, size_t n);
+/* Items of uneven size: count `items` and add their `cost` (e.g. bytes).
+ * The bar, rate and ETA then follow cost against params.cost_total, in
+ * params.unit, while the item count is shown alongside. */
+void tqdm_update_weighted(tqdm_t *tqdm, size_t items, size_t cost);
+void tqdm_update_dynamic_miniters(tqdm_t *tqdm);
+
+/* Work discovered while running (crawlers, recursive scans): raise the
+ * total by delta. Lock-free and safe from any thread. While the total
+ * grows, the ETA assumes discovery carries on at its measured rate, and
+ * {total_est} shows the total the bar is expected to end at. */
+void tqdm_add_total(tqdm_t *tqdm, size_t delta);
+
+/* Jobs with stages of different speeds (scan, transform, write): start
+ * the phase `name`, expected to take up expected_fraction of the total
+ * from here (<= 0: the rest). The rate model restarts for each phase, the
+ * name is shown after desc ({phase} in bar_format), and the ETA adds the
+ * phases still to come at the run history's pace, or the run's average
+ * without history. */
+void tqdm_phase_begin(tqdm_t *tqdm, const char *name,
+                      double expected_fraction);
 
 /* tqdm functions */
 void tqdm_close(tqdm_t *tqdm);
@@ -199,116 +569,95 @@ void tqdm_set_postfix(tqdm_t *tqdm, postfix_entry_t *postfix);
 void tqdm_set_postfix_str(tqdm_t *tqdm, const char *postfix, bool refresh);
 void tqdm_write(const char *s, FILE *file, const char *end, bool nolock);
 void tqdm_display(tqdm_t *tqdm, const char *msg, int pos);
-
-/* Format functions */
 tqdm_format_dict_t *tqdm_format_dict(tqdm_t *tqdm);
-char *tqdm_format_sizeof(double num, const char *suffix, int divisor);
-char *tqdm_format_interval(double t);
-char *tqdm_format_num(double n);
-char *tqdm_format_meter(size_t n, size_t total, double elapsed, 
-                       int ncols, const char *prefix, bool ascii,
-                       const char *unit, bool unit_scale, double rate,
-                       const char *bar_format, const char *postfix,
-                       int unit_divisor, size_t initial, const char *colour);
 
 /* Global lock */
 void tqdm_set_lock(pthread_mutex_t *lock);
 pthread_mutex_t *tqdm_get_lock(void);
 
-/* Context managers for external write mode and file wrapper */
-typedef struct {
-    tqdm_t *tqdm;
-    FILE *original_file;
-    bool lock_acquired;
-} tqdm_external_write_context_t;
-
+/* Context managers */
 tqdm_external_write_context_t *tqdm_external_write_mode(FILE *file, bool nolock);
 void tqdm_external_write_mode_exit(tqdm_external_write_context_t *ctx);
-
-/* File wrapper context manager for file operations */
-typedef struct {
-    tqdm_t *tqdm;
-    FILE *stream;
-    const char *method;
-    size_t (*read_func)(void *ptr, size_t size, size_t nmemb, FILE *stream);
-    size_t (*write_func)(const void *ptr, size_t size, size_t nmemb, FILE *stream);
-} tqdm_wrapattr_context_t;
-
 tqdm_wrapattr_context_t *tqdm_wrapattr(FILE *stream, const char *method, 
                                       size_t total, bool bytes, tqdm_params_t *params);
 void tqdm_wrapattr_exit(tqdm_wrapattr_context_t *ctx);
 
-/* Monitor thread */
+/* Copy len bytes (0: to end of input) from in_fd to out_fd, from their
+ * current offsets, with a bar in bytes unless params sets a unit. Uses
+ * copy_file_range, sendfile or splice where the kernel supports them and a
+ * large read/write loop otherwise; holes in a regular input are kept as
+ * holes in a regular output. Returns bytes copied, or -1 with errno set. */
+ssize_t tqdm_copy_fd(int in_fd, int out_fd, size_t len,
+                     const tqdm_params_t *params);
+
+/* Monitor thread: one per process, started with the first bar that has a
+ * stall_timeout and gone when the last one closes. It reads the counters
+ * from outside, so stall checks cost the update path nothing. A stalled
+ * bar shows "STALLED 42s" in its rate field and is redrawn by the monitor
+ * until it moves. Bars with a stall_timeout are registered on creation. */
 void tqdm_start_monitor(tqdm_t *tqdm);
 void tqdm_stop_monitor(tqdm_t *tqdm);
 void *tqdm_monitor_thread(void *arg);
 
-/* Range */
-range_iterator_t *range_create(int n);
-range_iterator_t *range_create_with_bounds(int start, int end);
-range_iterator_t *range_create_with_step(int start, int end, int step);
-void range_destroy(range_iterator_t *range);
-
-bool range_has_next(range_iterator_t *range);
-int range_next(range_iterator_t *range);
-
-/* Helper functions for tqdm parameters */
-tqdm_params_t tqdm_default_params(void);
-void tqdm_cleanup_params(tqdm_params_t *params);
-void tqdm_update_dynamic_miniters(tqdm_t *tqdm);
-
-/* Unicode block characters for progress bar */
-extern const char *tqdm_unicode_blocks[];
-extern const char *tqdm_ascii_blocks;
-
-/* Convenience functions for a more similar API to Python tqdm */
-range_iterator_t *trange(int n);
-range_iterator_t *trange_with_bounds(int start, int end);
-range_iterator_t *trange_with_step(int start, int end, int step);
-
-/* Environment variables */
-void tqdm_load_env_vars(tqdm_params_t *params);
-
-/* Postfix dictionary */
-postfix_entry_t *postfix_create(void);
-void postfix_add(postfix_entry_t **head, const char *key, const char *value);
-void postfix_add_int(postfix_entry_t **head, const char *key, int value);
-void postfix_add_float(postfix_entry_t **head, const char *key, double value);
-char *postfix_format(postfix_entry_t *head);
-void postfix_destroy(postfix_entry_t *head);
-
 /* Pandas integration stub */
 void tqdm_pandas_register(tqdm_params_t *params);
 
+/* Range loops: setup/teardown are out of line, the per-iteration step is a
+ * compare, an increment and a countdown */
+tqdm_range_loop_t *tqdm_range_loop_init(tqdm_range_loop_t *loop, int start,
+                                        int end, int step);
+/* The bar and stride of a loop over anything else (the C++ tqdm::view):
+ * total iterations (0 for params.total) and params (NULL for defaults).
+ * The caller advances its own iterator and counts down as above. */
+tqdm_range_loop_t *tqdm_loop_init(tqdm_range_loop_t *loop, size_t total,
+                                  const tqdm_params_t *params);
+void tqdm_range_loop_tick(tqdm_range_loop_t *loop);
+void tqdm_range_loop_fini(tqdm_range_loop_t *loop);
+
+static inline bool tqdm_range_loop_has_next(const tqdm_range_loop_t *loop) {
+    return loop->range.step > 0 ? loop->range.current < loop->range.total
+                                : loop->range.current > loop->range.total;
+}
+
+static inline void tqdm_range_loop_advance(tqdm_range_loop_t *loop) {
+    loop->range.current += loop->range.step;
+    if (--loop->countdown == 0)
+        tqdm_range_loop_tick(loop);
+}
+
 /* Automatic progress tracking macros */
 #define TQDM_FOR(type, var, start, end) \
-    for (range_iterator_t *_r_##var = trange_with_bounds(start, end); \
-         _r_##var; \
-         range_destroy(_r_##var), _r_##var = NULL) \
-    for (type var; _r_##var && range_has_next(_r_##var) && (var = range_next(_r_##var), 1); )
+    TQDM_FOR_STEP(type, var, start, end, 1)
 
 /* Range iteration with custom step */
 #define TQDM_FOR_STEP(type, var, start, end, step) \
-    for (range_iterator_t *_r_##var = trange_with_step(start, end, step); \
-         _r_##var; \
-         range_destroy(_r_##var), _r_##var = NULL) \
-    for (type var; _r_##var && range_has_next(_r_##var) && (var = range_next(_r_##var), 1); )
-
-/* Array iteration with progress tracking */
+    for (tqdm_range_loop_t _l_##var, \
+             *_p_##var = tqdm_range_loop_init(&_l_##var, start, end, step); \
+         _p_##var; \
+         tqdm_range_loop_fini(_p_##var), _p_##var = NULL) \
+    for (type var = (type)_l_##var.range.current; \
+         tqdm_range_loop_has_next(&_l_##var); \
+         tqdm_range_loop_advance(&_l_##var), \
+         var = (type)_l_##var.range.current)
+
+/* Array iteration with progress tracking (bar lives on the stack) */
 #define TQDM_FOR_ARRAY(type, var, array, size) \
-    for (tqdm_t *_t_##var = tqdm_create(array, (array) + (size), sizeof(*(array))); \
+    for (tqdm_t _s_##var, *_t_##var = tqdm_init_with_params(&_s_##var, \
+             array, (array) + (size), sizeof(*(array)), NULL); \
          _t_##var; \
-         tqdm_destroy(_t_##var), _t_##var = NULL) \
+         tqdm_fini(_t_##var), _t_##var = NULL) \
     for (type var; _t_##var && tqdm_has_next(_t_##var) && (var = (type)tqdm_next(_t_##var), 1); )
 
-/* Manual progress bar */
+/* Manual progress bar (bar lives on the stack) */
 #define TQDM_MANUAL(var, total) \
-    for (tqdm_t *var = tqdm_create_with_total(NULL, total, 0); \
-         var; tqdm_destroy(var), var = NULL)
+    for (tqdm_t _s_##var, *var = tqdm_init_with_total(&_s_##var, NULL, total, 0); \
+         var; tqdm_fini(var), var = NULL)
 
 /* Progress update for manual tracking*/
 #define TQDM_UPDATE(pbar) tqdm_update(pbar)
 
+#endif /* TQDM_DISABLE_ALL */
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,813 @@
+#ifndef TQDM_HPP
+#define TQDM_HPP
+
+/* C++17 interface over the C API: tqdm::bar owns a bar and destroys it on
+ * scope exit, and tqdm::view(range) wraps any range so that iterating it
+ * drives a bar. Header only; link tqdmlib as for C.
+ *
+ * The view's iterator counts down like TQDM_FOR: an increment is the
+ * underlying ++, a decrement and a rarely taken branch into the library.
+ * With TQDM_DISABLE_ALL it is the underlying iterator's ++ alone.
+ *
+ * tqdm::basic_bar<Lock, Counter, Clock> keeps its own counter, takes its
+ * locking and time source from policies and draws with the C renderer.
+ *
+ * Parallel algorithms with progress are in tqdm/execution.hpp.
+ *
+ * Under C++20, tqdm::format<"{desc}: {n}/{total}"> checks a bar_format at
+ * compile time and builds its shared style (the compiled format) once. */
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#if __cplusplus >= 202002L && __has_include(<ranges>)
+#include <ranges>
+#endif
+
+#include "tqdm/tqdm.h"
+
+namespace tqdm {
+
+#if defined(TQDM_DISABLE_ALL) && !defined(TQDM_BUILDING_LIBRARY)
+inline constexpr bool enabled = false;
+#else
+inline constexpr bool enabled = true;
+#endif
+
+/* Move-only owner of a tqdm_t. Creation failure throws std::bad_alloc; a
+ * moved-from or default-constructed bar is empty and every call on it is
+ * a no-op. */
+class bar {
+public:
+  bar() noexcept = default;
+
+  explicit bar(std::size_t total, const char *desc = nullptr)
+      : bar_(tqdm_create_with_total(nullptr, total, 0)) {
+    if (!bar_)
+      throw std::bad_alloc();
+    if (desc)
+      tqdm_set_description_str(bar_, desc, false);
+  }
+
+  /* The C signature predates const; params are only read */
+  explicit bar(const tqdm_params_t &params)
+      : bar_(tqdm_create_with_params(nullptr, nullptr, 0,
+                                     const_cast<tqdm_params_t *>(&params))) {
+    if (!bar_)
+      throw std::bad_alloc();
+  }
+
+  /* Adopt a bar from tqdm_create_* */
+  explicit bar(tqdm_t *adopt) noexcept : bar_(adopt) {}
+
+  bar(const bar &) = delete;
+  bar &operator=(const bar &) = delete;
+
+  bar(bar &&other) noexcept : bar_(other.release()) {}
+  bar &operator=(bar &&other) noexcept {
+    reset(other.release());
+    return *this;
+  }
+
+  ~bar() { reset(); }
+
+  tqdm_t *get() const noexcept { return bar_; }
+  explicit operator bool() const noexcept { return bar_ != nullptr; }
+
+  /* Give up ownership; the caller destroys it */
+  tqdm_t *release() noexcept { return std::exchange(bar_, nullptr); }
+
+  void reset(tqdm_t *adopt = nullptr) noexcept {
+    tqdm_t *old = std::exchange(bar_, adopt);
+    if (old)
+      tqdm_destroy(old);
+  }
+
+  void update(std::size_t n = 1) noexcept {
+    if (bar_)
+      tqdm_update_n(bar_, n);
+  }
+  bool update_to(std::size_t n) noexcept {
+    return bar_ && tqdm_update_to(bar_, n);
+  }
+  void update_weighted(std::size_t items, std::size_t cost) noexcept {
+    if (bar_)
+      tqdm_update_weighted(bar_, items, cost);
+  }
+  void add_total(std::size_t delta) noexcept {
+    if (bar_)
+      tqdm_add_total(bar_, delta);
+  }
+  void phase(const char *name, double expected_fraction = 0) noexcept {
+    if (bar_)
+      tqdm_phase_begin(bar_, name, expected_fraction);
+  }
+  void set_description(const char *desc, bool refresh = true) noexcept {
+    if (bar_)
+      tqdm_set_description_str(bar_, desc, refresh);
+  }
+  void set_postfix(const char *postfix, bool refresh = true) noexcept {
+    if (bar_)
+      tqdm_set_postfix_str(bar_, postfix, refresh);
+  }
+  void refresh() noexcept {
+    if (bar_)
+      tqdm_refresh(bar_);
+  }
+  /* Draw the final frame now; destruction still frees the bar */
+  void close() noexcept {
+    if (bar_)
+      tqdm_close(bar_);
+  }
+
+private:
+  tqdm_t *bar_ = nullptr;
+};
+
+namespace detail {
+
+/* Lvalue ranges are referred to, rvalues are moved into the view */
+template <class R>
+struct range_ref {
+  R *range;
+  R &get() const noexcept { return *range; }
+};
+
+template <class R>
+struct range_own {
+  R range;
+  R &get() noexcept { return range; }
+};
+
+template <class R>
+using range_store = std::conditional_t<std::is_lvalue_reference_v<R>,
+                                       range_ref<std::remove_reference_t<R>>,
+                                       range_own<std::remove_cv_t<R>>>;
+
+/* Iterations known up front: std::size, or the distance for
+ * random-access ranges; 0 (no total) otherwise */
+template <class R, class = void>
+struct has_size : std::false_type {};
+template <class R>
+struct has_size<R, std::void_t<decltype(std::size(std::declval<R &>()))>>
+    : std::true_type {};
+
+template <class R>
+std::size_t range_total(R &range) {
+  using std::begin;
+  using std::end;
+  if constexpr (has_size<R>::value) {
+    return static_cast<std::size_t>(std::size(range));
+  } else if constexpr (std::is_base_of_v<
+                           std::random_access_iterator_tag,
+                           typename std::iterator_traits<decltype(begin(
+                               range))>::iterator_category>) {
+    auto n = end(range) - begin(range);
+    return n > 0 ? static_cast<std::size_t>(n) : 0;
+  } else {
+    return 0;
+  }
+}
+
+/* The loop state holds a whole tqdm_t, so it lives on the heap (once per
+ * loop) where moving the view cannot invalidate its iterators */
+struct loop_deleter {
+  void operator()(tqdm_range_loop_t *loop) const noexcept {
+    tqdm_range_loop_fini(loop);
+    delete loop;
+  }
+};
+using loop_ptr = std::unique_ptr<tqdm_range_loop_t, loop_deleter>;
+
+/* Marks range_view as a std::ranges::view, so it pipes into adaptors */
+#if defined(__cpp_lib_ranges)
+using view_base = std::ranges::view_base;
+#else
+struct view_base {};
+#endif
+
+inline loop_ptr make_loop(std::size_t total, const tqdm_params_t *params) {
+  if constexpr (!enabled)
+    return nullptr;
+  loop_ptr loop(new tqdm_range_loop_t());
+  tqdm_loop_init(loop.get(), total, params);
+  return loop;
+}
+
+} // namespace detail
+
+/* What tqdm::view returns. Iterating it is single-pass: every increment
+ * is counted, so its iterators are input iterators whatever the range. */
+template <class R>
+class range_view : public detail::view_base {
+  using base_iterator =
+      decltype(std::begin(std::declval<std::remove_reference_t<R> &>()));
+  using base_sentinel =
+      decltype(std::end(std::declval<std::remove_reference_t<R> &>()));
+
+public:
+  class sentinel {
+  public:
+    sentinel() = default;
+    explicit sentinel(base_sentinel end) : end_(std::move(end)) {}
+
+    const base_sentinel &base() const { return end_; }
+
+  private:
+    base_sentinel end_{};
+  };
+
+  class iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type =
+        typename std::iterator_traits<base_iterator>::value_type;
+    using difference_type =
+        typename std::iterator_traits<base_iterator>::difference_type;
+    using reference =
+        typename std::iterator_traits<base_iterator>::reference;
+    using pointer = typename std::iterator_traits<base_iterator>::pointer;
+
+    iterator() = default;
+    iterator(base_iterator it, tqdm_range_loop_t *loop)
+        : it_(std::move(it)), loop_(loop) {}
+
+    reference operator*() const { return *it_; }
+    base_iterator base() const { return it_; }
+
+    iterator &operator++() {
+      ++it_;
+      if constexpr (enabled) {
+        if (--loop_->countdown == 0)
+          tqdm_range_loop_tick(loop_);
+      }
+      return *this;
+    }
+    void operator++(int) { ++*this; }
+
+    friend bool operator==(const iterator &it, const sentinel &s) {
+      return it.it_ == s.base();
+    }
+    friend bool operator!=(const iterator &it, const sentinel &s) {
+      return !(it == s);
+    }
+    friend bool operator==(const sentinel &s, const iterator &it) {
+      return it == s;
+    }
+    friend bool operator!=(const sentinel &s, const iterator &it) {
+      return !(it == s);
+    }
+
+  private:
+    base_iterator it_{};
+    tqdm_range_loop_t *loop_ = nullptr;
+  };
+
+  range_view(R &&range, const tqdm_params_t *params)
+      : store_(store(std::forward<R>(range))),
+        loop_(detail::make_loop(detail::range_total(store_.get()), params)) {}
+
+  iterator begin() { return iterator(std::begin(store_.get()), loop_.get()); }
+  sentinel end() { return sentinel(std::end(store_.get())); }
+
+  /* The loop's bar (nullptr when disabled), e.g. for set_postfix */
+  tqdm_t *get() const noexcept {
+    return loop_ && loop_->active ? &loop_->bar : nullptr;
+  }
+
+private:
+  static detail::range_store<R> store(R &&range) {
+    if constexpr (std::is_lvalue_reference_v<R>)
+      return {&range};
+    else
+      return {std::move(range)};
+  }
+
+  detail::range_store<R> store_;
+  detail::loop_ptr loop_;
+};
+
+template <class R>
+range_view<R> view(R &&range, const tqdm_params_t &params) {
+  return range_view<R>(std::forward<R>(range), &params);
+}
+
+template <class R>
+range_view<R> view(R &&range, const char *desc = nullptr) {
+  range_view<R> v(std::forward<R>(range), nullptr);
+  if (desc && v.get())
+    tqdm_set_description_str(v.get(), desc, false);
+  return v;
+}
+
+
+/* Policies for basic_bar. Locks guard drawing only; counting goes
+ * through the counter, and a thread that finds the lock taken skips the
+ * frame rather than waiting. */
+namespace policy {
+
+/* Single-threaded bars */
+struct unlocked_lock {
+  bool try_lock() noexcept { return true; }
+  void lock() noexcept {}
+  void unlock() noexcept {}
+};
+
+class mutex_lock {
+public:
+  bool try_lock() noexcept { return mutex_.try_lock(); }
+  void lock() { mutex_.lock(); }
+  void unlock() noexcept { mutex_.unlock(); }
+
+private:
+  std::mutex mutex_;
+};
+
+/* Spins (yielding) instead of sleeping in the kernel */
+class atomic_lock {
+public:
+  bool try_lock() noexcept {
+    return !flag_.test_and_set(std::memory_order_acquire);
+  }
+  void lock() noexcept {
+    while (!try_lock())
+      std::this_thread::yield();
+  }
+  void unlock() noexcept { flag_.clear(std::memory_order_release); }
+
+private:
+  std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+};
+
+class plain_counter {
+public:
+  void add(std::size_t n) noexcept { n_ += n; }
+  std::size_t load() const noexcept { return n_; }
+
+private:
+  std::size_t n_ = 0;
+};
+
+class atomic_counter {
+public:
+  void add(std::size_t n) noexcept {
+    n_.fetch_add(n, std::memory_order_relaxed);
+  }
+  std::size_t load() const noexcept {
+    return n_.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<std::size_t> n_{0};
+};
+
+/* Each thread adds to a shard on its own cache line, so many writers do
+ * not share one; reading sums the shards */
+class sharded_counter {
+public:
+  void add(std::size_t n) noexcept {
+    shards_[slot()].n.fetch_add(n, std::memory_order_relaxed);
+  }
+  std::size_t load() const noexcept {
+    std::size_t n = 0;
+    for (const shard &s : shards_)
+      n += s.n.load(std::memory_order_relaxed);
+    return n;
+  }
+
+private:
+  static constexpr std::size_t shard_count = 64;
+  struct alignas(64) shard {
+    std::atomic<std::size_t> n{0};
+  };
+
+  /* Threads take shards in turn; past shard_count they share */
+  static std::size_t slot() noexcept {
+    static std::atomic<std::size_t> next{0};
+    thread_local std::size_t mine =
+        next.fetch_add(1, std::memory_order_relaxed) % shard_count;
+    return mine;
+  }
+
+  shard shards_[shard_count];
+};
+
+/* Clocks return seconds from an arbitrary origin */
+struct steady_clock {
+  double now() const noexcept {
+    return std::chrono::duration<double>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+};
+
+/* The kernel's tick-granular clock (a few ms), much cheaper to read where
+ * available; the steady clock elsewhere */
+struct coarse_clock {
+  double now() const noexcept {
+#if defined(CLOCK_MONOTONIC_COARSE)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#else
+    return steady_clock().now();
+#endif
+  }
+};
+
+/* Time that moves only when told to, for tests */
+class virtual_clock {
+public:
+  double now() const noexcept { return t_; }
+  void advance(double seconds) noexcept { t_ += seconds; }
+
+private:
+  double t_ = 0;
+};
+
+} // namespace policy
+
+/* A bar whose counting, locking and time source are compile-time
+ * policies, so a single-threaded bar has no atomics or locks at all and
+ * tests can drive time by hand. Frames use the C renderer through a
+ * style. An update adds to the counter and reads the clock; a frame is
+ * drawn when mininterval has passed and the lock is free. Like a tqdm_t,
+ * a bar that is disabled (params or TQDM_DISABLE) or writes to /dev/null
+ * only counts, and nothing is drawn before delay or between fewer than
+ * miniters updates. Bad params throw std::invalid_argument, allocation
+ * failure std::bad_alloc; close() throws what the policy's lock does. */
+template <class Lock = policy::mutex_lock,
+          class Counter = policy::atomic_counter,
+          class Clock = policy::steady_clock>
+class basic_bar {
+public:
+  explicit basic_bar(std::size_t total, const char *desc = nullptr) {
+    tqdm_params_t params = tqdm_default_params();
+    params.total = total;
+    setup(params);
+    tqdm_cleanup_params(&params);
+    if (desc)
+      desc_ = desc;
+  }
+
+  explicit basic_bar(const tqdm_params_t &params) { setup(params); }
+
+  basic_bar(const basic_bar &) = delete;
+  basic_bar &operator=(const basic_bar &) = delete;
+
+  /* A lock that fails here loses the final frame, not the process */
+  ~basic_bar() {
+    try {
+      close();
+    } catch (...) {
+    }
+    tqdm_style_release(style_);
+  }
+
+  void update(std::size_t n = 1) noexcept {
+    if constexpr (enabled) {
+      counter_.add(n);
+      if (silent_)
+        return;
+      double now = clock_.now();
+      if (now - last_print_.load(std::memory_order_relaxed) < mininterval_ ||
+          !lock_.try_lock())
+        return;
+      if (!closed_ &&
+          now - last_print_.load(std::memory_order_relaxed) >= mininterval_)
+        maybe_draw(now);
+      lock_.unlock();
+    }
+  }
+
+  /* Draw the final frame; later updates still count but draw nothing */
+  void close() {
+    if constexpr (enabled) {
+      std::lock_guard<Lock> guard(lock_);
+      if (closed_)
+        return;
+      closed_ = true;
+      if (silent_)
+        return;
+      double now = clock_.now();
+      if (leave_) {
+        /* Still inside the delay: the bar never appears */
+        if (!displayed_ && now - start_ < delay_)
+          return;
+        draw(now);
+        fputs("\n", file_);
+      } else if (displayed_) {
+        fputs("\r\033[K", file_);
+      }
+      fflush(file_);
+    }
+  }
+
+  std::size_t n() const noexcept { return counter_.load(); }
+  Clock &clock() noexcept { return clock_; }
+
+private:
+  void setup(const tqdm_params_t &params) {
+    style_ = tqdm_style_create(&params);
+    if (!style_) {
+      if (errno == EINVAL)
+        throw std::invalid_argument("tqdm: invalid bar_format");
+      throw std::bad_alloc();
+    }
+    if (params.desc)
+      desc_ = params.desc;
+    file_ = params.file ? params.file : stderr;
+    silent_ = params.disable || tqdm_output_discarded(file_);
+    total_ = params.total;
+    ncols_ = params.ncols;
+    mininterval_ = params.mininterval >= 0 ? params.mininterval : 0.1;
+    miniters_ = params.miniters;
+    delay_ = params.delay;
+    smoothing_ = params.smoothing >= 0 && params.smoothing <= 1
+                     ? params.smoothing
+                     : 0.3;
+    leave_ = params.leave;
+    start_ = last_rate_time_ = clock_.now();
+    last_print_.store(start_, std::memory_order_relaxed);
+  }
+
+  /* With the lock held: the refresh rules of tqdm_update_n. The initial
+   * delay keeps the mininterval cadence; a finished bar is always drawn. */
+  void maybe_draw(double now) {
+    if (!displayed_ && now - start_ < delay_) {
+      last_print_.store(now, std::memory_order_relaxed);
+      return;
+    }
+    std::size_t n = counter_.load();
+    if (n - printed_n_ < miniters_ && !(total_ > 0 && n >= total_))
+      return;
+    draw(now);
+  }
+
+  /* With the lock held. The rate is an exponential moving average of the
+   * rates between frames. */
+  void draw(double now) {
+    std::size_t n = counter_.load();
+    double dt = now - last_rate_time_;
+    if (dt > 0 && n >= last_n_) {
+      double r = (n - last_n_) / dt;
+      rate_ = rate_ > 0 && smoothing_ > 0
+                  ? smoothing_ * r + (1 - smoothing_) * rate_
+                  : r;
+      last_n_ = n;
+      last_rate_time_ = now;
+    }
+
+    tqdm_frame_t frame = {};
+    frame.n = n;
+    frame.total = total_;
+    frame.elapsed = now - start_;
+    frame.rate = rate_;
+    frame.remaining = total_ > 0 && rate_ > 0 && n < total_
+                          ? (total_ - n) / rate_
+                          : -1.0;
+    frame.desc = desc_.empty() ? nullptr : desc_.c_str();
+    frame.ncols = ncols_;
+
+    buf_[0] = '\r';
+    std::size_t len =
+        tqdm_style_render(style_, &frame, buf_ + 1, sizeof(buf_) - 1);
+    fwrite(buf_, 1, len + 1, file_);
+    fflush(file_);
+    displayed_ = true;
+    printed_n_ = n;
+    last_print_.store(now, std::memory_order_relaxed);
+  }
+
+  Lock lock_;
+  Counter counter_;
+  Clock clock_;
+  std::atomic<double> last_print_{0};
+
+  /* Under the lock */
+  tqdm_style_t *style_ = nullptr;
+  std::string desc_;
+  FILE *file_ = stderr;
+  std::size_t total_ = 0;
+  int ncols_ = 0;
+  double mininterval_ = 0.1;
+  std::size_t miniters_ = 0;
+  double delay_ = 0;
+  double smoothing_ = 0.3;
+  bool silent_ = false; /* Disabled or discarded output; set once */
+  bool leave_ = true;
+  bool closed_ = false;
+  bool displayed_ = false;
+  std::size_t printed_n_ = 0;
+  double start_ = 0;
+  double last_rate_time_ = 0;
+  std::size_t last_n_ = 0;
+  double rate_ = 0;
+  char buf_[1024];
+};
+
+#if defined(__cpp_nontype_template_args) &&                                  \
+    __cpp_nontype_template_args >= 201911L
+namespace detail {
+
+/* A string literal as a template argument */
+template <std::size_t N>
+struct fixed_string {
+  char text[N];
+
+  constexpr fixed_string(const char (&s)[N]) {
+    for (std::size_t i = 0; i < N; i++)
+      text[i] = s[i];
+  }
+};
+
+/* The bar_format grammar of tqdm_format_compile (render.c), evaluated by
+ * the compiler from the same TQDM_FORMAT_FIELDS list */
+struct format_field {
+  const char *name;
+  char type; /* 's' string, 'f' real, 'd' integer, 'b' the bar */
+};
+
+#define TQDM_FORMAT_FIELD(name, id, type) {#name, type},
+inline constexpr format_field format_fields[] = {
+    TQDM_FORMAT_FIELDS(TQDM_FORMAT_FIELD)};
+#undef TQDM_FORMAT_FIELD
+inline constexpr std::size_t format_max_tokens = TQDM_FORMAT_MAX_TOKENS;
+
+constexpr char format_field_type(const char *name, std::size_t len) {
+  for (const format_field &f : format_fields) {
+    std::size_t i = 0;
+    while (i < len && f.name[i] == name[i])
+      i++;
+    if (i == len && f.name[len] == '\0')
+      return f.type;
+  }
+  return 0;
+}
+
+constexpr bool format_digits(const char *&p, const char *end,
+                             int max_digits) {
+  for (int digits = 0; p < end && *p >= '0' && *p <= '9'; p++) {
+    if (++digits > max_digits)
+      return false;
+  }
+  return true;
+}
+
+/* [align][sign][#][0][width][.precision][type] for numbers,
+ * [align][width] for strings */
+constexpr bool format_spec_valid(char type, const char *p, const char *end) {
+  char align = 0;
+  if (p < end && (*p == '<' || *p == '>' || *p == '^'))
+    align = *p++;
+  if (type == 's')
+    return format_digits(p, end, 3) && p == end;
+  if ((type != 'f' && type != 'd') || align == '^')
+    return false;
+
+  if (p < end && (*p == '+' || *p == ' '))
+    p++;
+  if (p < end && *p == '#')
+    p++;
+  if (p < end && *p == '0')
+    p++;
+  if (!format_digits(p, end, 3))
+    return false;
+  if (p < end && *p == '.') {
+    const char *dot = p++;
+    if (!format_digits(p, end, 2) || p == dot + 1)
+      return false;
+  }
+  for (char conv : {'d', 'e', 'E', 'f', 'F', 'g', 'G'}) {
+    if (p < end && *p == conv) {
+      p++;
+      break;
+    }
+  }
+  return p == end;
+}
+
+constexpr bool format_valid(const char *text, std::size_t len) {
+  if (len > 0xffff)
+    return false;
+
+  const char *end = text + len;
+  const char *lit = text;
+  const char *p = text;
+  std::size_t tokens = 0;
+  while (p < end) {
+    if (p + 1 < end && ((p[0] == '{' && p[1] == '{') ||
+                        (p[0] == '}' && p[1] == '}'))) {
+      tokens++; /* The literal up to and including one brace */
+      p += 2;
+      lit = p;
+      continue;
+    }
+    if (*p == '}')
+      return false;
+    if (*p != '{') {
+      p++;
+      continue;
+    }
+    tokens += p != lit;
+
+    const char *name = p + 1;
+    const char *close = name;
+    while (close < end && *close != '}')
+      close++;
+    if (close == end)
+      return false;
+    const char *colon = name;
+    while (colon < close && *colon != ':')
+      colon++;
+
+    char type = format_field_type(name, (std::size_t)(colon - name));
+    if (!type)
+      return false;
+    tokens++;
+    if (colon < close && !format_spec_valid(type, colon + 1, close))
+      return false;
+
+    p = close + 1;
+    lit = p;
+  }
+  tokens += p != lit;
+  return tokens <= format_max_tokens;
+}
+
+/* A style with text as its bar_format; NULL params means the defaults */
+inline tqdm_style_t *format_style(const tqdm_params_t *params,
+                                  const char *text) {
+  tqdm_params_t p = params ? *params : tqdm_default_params();
+  char *own = p.bar_format;
+  p.bar_format = const_cast<char *>(text);
+  tqdm_style_t *style = tqdm_style_create(&p);
+  if (!params) {
+    p.bar_format = own;
+    tqdm_cleanup_params(&p);
+  }
+  return style;
+}
+
+struct style_ref {
+  tqdm_style_t *style;
+  ~style_ref() { tqdm_style_release(style); }
+};
+
+} // namespace detail
+
+/* A bar_format checked by the compiler: an unknown field, a bad spec or
+ * an unbalanced brace is a compile error rather than a runtime fallback
+ * to the default layout. Bars made from it share one style, so the format
+ * is compiled once and each frame only walks its tokens. */
+template <detail::fixed_string Text>
+class format {
+  static_assert(detail::format_valid(Text.text, sizeof(Text.text) - 1),
+                "tqdm::format: invalid bar_format");
+
+public:
+  static constexpr const char *text = Text.text;
+
+  /* Shared style with the default params, built on first use */
+  static tqdm_style_t *style() {
+    static detail::style_ref shared{detail::format_style(nullptr, text)};
+    return shared.style;
+  }
+
+  /* A bar in this format; throws std::bad_alloc like tqdm::bar */
+  static bar make(std::size_t total, const char *desc = nullptr) {
+    tqdm_style_t *s = style();
+    tqdm_t *t = s ? tqdm_create_with_style(s, desc, total) : nullptr;
+    if (!t)
+      throw std::bad_alloc();
+    return bar(t);
+  }
+
+  /* The same with other params (file, unit, ...); their bar_format is
+   * replaced and the style is the bar's own */
+  static bar make(const tqdm_params_t &params) {
+    tqdm_style_t *s = detail::format_style(&params, text);
+    tqdm_t *t = s ? tqdm_create_with_style(s, params.desc, params.total)
+                  : nullptr;
+    tqdm_style_release(s);
+    if (!t)
+      throw std::bad_alloc();
+    return bar(t);
+  }
+};
+#endif /* __cpp_nontype_template_args */
+
+} // namespace tqdm
+
+#endif /* TQDM_HPP */
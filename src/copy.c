@@ -0,0 +1,258 @@
+#define _GNU_SOURCE /* copy_file_range, splice, SEEK_DATA */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+#include "tqdm_internal.h"
+
+/* =============================
+ * fd-to-fd copies
+ * =============================
+ * Each stretch of data goes through the first mechanism that works for
+ * this pair of fds: copy_file_range (in-kernel, reflinks where the
+ * filesystem can), sendfile, splice (one end a pipe), then read/write
+ * through an aligned buffer. A mechanism that reports itself unsupported
+ * is not tried again. Between regular files, holes in the input found with
+ * SEEK_DATA/SEEK_HOLE are recreated by seeking the output instead of
+ * writing zeros. The bar moves once per chunk; skipped holes count too.
+ */
+#define TQDM_COPY_CHUNK (8u << 20)     /* Bytes per syscall */
+#define TQDM_COPY_BUF_SIZE (1u << 20)  /* read/write fallback */
+#define TQDM_COPY_BUF_ALIGN 4096
+
+typedef enum {
+  TQDM_COPY_RANGE,
+  TQDM_COPY_SENDFILE,
+  TQDM_COPY_SPLICE,
+  TQDM_COPY_RW
+} tqdm_copy_method_t;
+
+typedef struct {
+  int in, out;
+  tqdm_copy_method_t method; /* First mechanism still worth trying */
+  bool in_pipe, out_pipe;
+  char *buf; /* Allocated on first use */
+  tqdm_t *bar;
+} tqdm_copy_t;
+
+/* The errors with which a mechanism says "not for these fds" */
+static bool tqdm_copy_unsupported(int err) {
+  return err == ENOSYS || err == EINVAL || err == EXDEV ||
+         err == EOPNOTSUPP || err == EBADF || err == ESPIPE;
+}
+
+/* read/write, retrying short writes; returns bytes moved, 0 at EOF */
+static ssize_t tqdm_copy_rw(tqdm_copy_t *c, size_t len) {
+  if (!c->buf &&
+      posix_memalign((void **)&c->buf, TQDM_COPY_BUF_ALIGN,
+                     TQDM_COPY_BUF_SIZE) != 0) {
+    c->buf = NULL;
+    errno = ENOMEM;
+    return -1;
+  }
+  if (len > TQDM_COPY_BUF_SIZE)
+    len = TQDM_COPY_BUF_SIZE;
+
+  ssize_t got = read(c->in, c->buf, len);
+  if (got <= 0)
+    return got;
+  for (ssize_t put = 0; put < got;) {
+    ssize_t w = write(c->out, c->buf + put, (size_t)(got - put));
+    if (w < 0) {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    put += w;
+  }
+  return got;
+}
+
+/* Move up to len bytes with the best mechanism left; 0 at EOF */
+static ssize_t tqdm_copy_chunk(tqdm_copy_t *c, size_t len) {
+  if (len > TQDM_COPY_CHUNK)
+    len = TQDM_COPY_CHUNK;
+
+  for (;;) {
+    ssize_t n = -1;
+    switch (c->method) {
+#ifdef __linux__
+    case TQDM_COPY_RANGE:
+      n = copy_file_range(c->in, NULL, c->out, NULL, len, 0);
+      break;
+    case TQDM_COPY_SENDFILE:
+      n = sendfile(c->out, c->in, NULL, len);
+      break;
+    case TQDM_COPY_SPLICE:
+      if (!c->in_pipe && !c->out_pipe) {
+        errno = EINVAL;
+        break;
+      }
+      n = splice(c->in, NULL, c->out, NULL, len, SPLICE_F_MOVE);
+      break;
+#else
+    case TQDM_COPY_RANGE:
+    case TQDM_COPY_SENDFILE:
+    case TQDM_COPY_SPLICE:
+      errno = ENOSYS;
+      break;
+#endif
+    case TQDM_COPY_RW:
+      n = tqdm_copy_rw(c, len);
+      break;
+    }
+
+    if (n >= 0)
+      return n;
+    if (errno == EINTR)
+      continue;
+    if (c->method == TQDM_COPY_RW || !tqdm_copy_unsupported(errno))
+      return -1;
+    c->method++;
+  }
+}
+
+/* Copy len bytes (to EOF when unbounded) of data, no hole skipping */
+static ssize_t tqdm_copy_data(tqdm_copy_t *c, size_t len, bool bounded,
+                              size_t *copied) {
+  while (!bounded || len > 0) {
+    ssize_t n = tqdm_copy_chunk(c, bounded ? len : TQDM_COPY_CHUNK);
+    if (n < 0)
+      return -1;
+    if (n == 0)
+      break;
+    *copied += (size_t)n;
+    if (bounded)
+      len -= (size_t)n;
+    tqdm_update_n(c->bar, (size_t)n);
+  }
+  return 0;
+}
+
+#ifdef SEEK_DATA
+/* Between regular files: copy data extents and seek over holes. Only
+ * past the output's end, where unwritten bytes read as zeros, and not in
+ * append mode, where seeks do not move writes. Returns 1 when holes
+ * cannot be skipped, so the caller copies plainly. */
+static int tqdm_copy_sparse(tqdm_copy_t *c, off_t start, off_t end,
+                            size_t *copied) {
+  struct stat st;
+  off_t pos = start, out_start = lseek(c->out, 0, SEEK_CUR);
+  int flags = fcntl(c->out, F_GETFL);
+  if (out_start < 0 || flags < 0 || (flags & O_APPEND) ||
+      fstat(c->out, &st) < 0 || out_start < st.st_size)
+    return 1;
+
+  while (pos < end) {
+    off_t data = lseek(c->in, pos, SEEK_DATA);
+    if (data < 0 && errno == ENXIO)
+      data = end; /* Only a hole is left */
+    else if (data < 0)
+      return pos == start ? 1 : -1;
+    if (data > end)
+      data = end;
+
+    if (data > pos) {
+      /* Hole: leave the output unwritten there */
+      if (lseek(c->out, out_start + (data - start), SEEK_SET) < 0)
+        return -1;
+      *copied += (size_t)(data - pos);
+      tqdm_update_n(c->bar, (size_t)(data - pos));
+      pos = data;
+      if (pos == end)
+        break;
+    }
+
+    off_t hole = lseek(c->in, pos, SEEK_HOLE);
+    if (hole < 0 || hole > end)
+      hole = end;
+    if (lseek(c->in, pos, SEEK_SET) < 0)
+      return -1;
+    size_t before = *copied;
+    if (tqdm_copy_data(c, (size_t)(hole - pos), true, copied) < 0)
+      return -1;
+    if (*copied - before < (size_t)(hole - pos)) {
+      pos += (off_t)(*copied - before); /* Input shrank under us */
+      break;
+    }
+    pos = hole;
+  }
+
+  /* A trailing hole has no data to extend the output with */
+  off_t out_end = out_start + (pos - start);
+  if (fstat(c->out, &st) < 0 ||
+      (st.st_size < out_end && ftruncate(c->out, out_end) < 0) ||
+      lseek(c->out, out_end, SEEK_SET) < 0 ||
+      lseek(c->in, pos, SEEK_SET) < 0)
+    return -1;
+  return 0;
+}
+#endif
+
+ssize_t tqdm_copy_fd(int in_fd, int out_fd, size_t len,
+                     const tqdm_params_t *params) {
+  struct stat in_st, out_st;
+  if (fstat(in_fd, &in_st) < 0 || fstat(out_fd, &out_st) < 0)
+    return -1;
+
+  /* Regular input: the bytes left from its offset bound the copy. Files
+   * that report no size (procfs, sysfs) are generated as they are read:
+   * copy them to EOF with read/write, since the in-kernel paths may see
+   * them as empty. */
+  bool bounded = len > 0;
+  bool sizeless = S_ISREG(in_st.st_mode) && in_st.st_size == 0;
+  off_t in_pos = S_ISREG(in_st.st_mode) && !sizeless
+                     ? lseek(in_fd, 0, SEEK_CUR)
+                     : -1;
+  if (in_pos >= 0 && in_st.st_size >= in_pos) {
+    size_t left = (size_t)(in_st.st_size - in_pos);
+    if (!bounded || len > left)
+      len = left;
+    bounded = true;
+  }
+
+  tqdm_params_t p = params ? *params : tqdm_static_default_params();
+  if (p.total == 0 && bounded)
+    p.total = len;
+  /* Rate and ETA in bytes unless the caller chose a unit */
+  if (!p.unit || !strcmp(p.unit, "it")) {
+    p.unit = (char *)"B";
+    p.unit_scale = true;
+    p.unit_divisor = 1024.0f;
+  }
+
+  tqdm_copy_t c = {
+      .in = in_fd,
+      .out = out_fd,
+      .method = sizeless ? TQDM_COPY_RW : TQDM_COPY_RANGE,
+      .in_pipe = S_ISFIFO(in_st.st_mode),
+      .out_pipe = S_ISFIFO(out_st.st_mode),
+  };
+  c.bar = tqdm_create_with_params(NULL, NULL, 0, &p);
+  if (!c.bar)
+    return -1;
+
+  size_t copied = 0;
+  int rc = 1;
+#ifdef SEEK_DATA
+  if (bounded && in_pos >= 0 && S_ISREG(out_st.st_mode))
+    rc = tqdm_copy_sparse(&c, in_pos, in_pos + (off_t)len, &copied);
+#endif
+  if (rc > 0)
+    rc = tqdm_copy_data(&c, len, bounded, &copied);
+
+  int err = errno;
+  free(c.buf);
+  tqdm_destroy(c.bar);
+  if (rc < 0) {
+    errno = err;
+    return -1;
+  }
+  return (ssize_t)copied;
+}
@@ -0,0 +1,386 @@
+#include <math.h>
+#include <string.h>
+
+#include "tqdm_internal.h"
+
+/* =============================
+ * Rate estimators
+ * =============================
+ * Each keeps its state in the bar's tqdm_estimator_state_t and is fed
+ * (seconds since start, count) whenever the bar refreshes.
+ */
+#define TQDM_STATE_FITS(type, name)                                          \
+  typedef char tqdm_state_fits_##name[sizeof(type) <=                        \
+                                              sizeof(tqdm_estimator_state_t) \
+                                          ? 1                                \
+                                          : -1]
+
+/* Lifetime average, as tqdm.c computed it before estimators */
+typedef struct {
+  double t;
+  double n;
+} tqdm_avg_state_t;
+TQDM_STATE_FITS(tqdm_avg_state_t, avg);
+
+static void tqdm_avg_reset(tqdm_estimator_state_t *state,
+                           const tqdm_params_t *params) {
+  (void)params;
+  memset(state, 0, sizeof(tqdm_avg_state_t));
+}
+
+static void tqdm_avg_sample(tqdm_estimator_state_t *state, double t,
+                            double n) {
+  tqdm_avg_state_t *s = (tqdm_avg_state_t *)state;
+  s->t = t;
+  s->n = n;
+}
+
+static double tqdm_avg_rate(const tqdm_estimator_state_t *state) {
+  const tqdm_avg_state_t *s = (const tqdm_avg_state_t *)state;
+  return s->t > 1e-6 ? s->n / s->t : 0.0;
+}
+
+const tqdm_estimator_t tqdm_estimator_avg = {
+    "avg", tqdm_avg_reset, tqdm_avg_sample, tqdm_avg_rate};
+
+/* Python tqdm's EMA: count and time deltas are smoothed separately, with
+ * the bias of the zero start corrected.
+ *
+ * With TQDM_SMOOTHING_AUTO, alpha follows the coefficient of variation
+ * (cv) of the per-interval rates, kept as an exponentially weighted
+ * Welford mean and variance. An EMA of independent samples has
+ * var * alpha / (2 - alpha) variance, so alpha = 2t^2 / (cv^2 + t^2) keeps
+ * the shown rate within about t of its mean: steady work gets a nimble
+ * estimate, bursty work a smooth one. */
+#define TQDM_EMA_AUTO_TARGET 0.1   /* Relative jitter allowed in the rate */
+#define TQDM_EMA_AUTO_MEMORY 0.05  /* Weight of a new rate in the stats */
+#define TQDM_EMA_AUTO_MIN 0.01
+#define TQDM_EMA_AUTO_WARMUP 4     /* Intervals before alpha is tuned */
+
+typedef struct {
+  double alpha;
+  double last_t;
+  double last_n;
+  double dn;
+  double dt;
+  double weight; /* 1 - (1 - alpha)^calls */
+  bool adaptive;
+  size_t intervals;
+  double rate_mean;
+  double rate_var;
+} tqdm_ema_state_t;
+TQDM_STATE_FITS(tqdm_ema_state_t, ema);
+
+static void tqdm_ema_reset(tqdm_estimator_state_t *state,
+                           const tqdm_params_t *params) {
+  tqdm_ema_state_t *s = (tqdm_ema_state_t *)state;
+  memset(s, 0, sizeof(*s));
+  s->adaptive = params->smoothing == TQDM_SMOOTHING_AUTO;
+  if (s->adaptive)
+    s->alpha = 0.3;
+  else
+    s->alpha = params->smoothing > 0 ? params->smoothing : 1.0;
+}
+
+/* Fold one interval's rate into the running stats and retune alpha */
+static void tqdm_ema_tune(tqdm_ema_state_t *s, double rate) {
+  /* Plain Welford until there are 1/memory intervals, then exponential */
+  s->intervals++;
+  double w = 1.0 / s->intervals;
+  if (w < TQDM_EMA_AUTO_MEMORY)
+    w = TQDM_EMA_AUTO_MEMORY;
+  double diff = rate - s->rate_mean;
+  s->rate_mean += w * diff;
+  s->rate_var = (1 - w) * (s->rate_var + w * diff * diff);
+
+  if (s->intervals < TQDM_EMA_AUTO_WARMUP || s->rate_mean <= 0)
+    return;
+  double cv2 = s->rate_var / (s->rate_mean * s->rate_mean);
+  double t2 = TQDM_EMA_AUTO_TARGET * TQDM_EMA_AUTO_TARGET;
+  s->alpha = 2 * t2 / (cv2 + t2);
+  if (s->alpha > 1)
+    s->alpha = 1;
+  else if (s->alpha < TQDM_EMA_AUTO_MIN)
+    s->alpha = TQDM_EMA_AUTO_MIN;
+}
+
+static void tqdm_ema_sample(tqdm_estimator_state_t *state, double t,
+                            double n) {
+  tqdm_ema_state_t *s = (tqdm_ema_state_t *)state;
+  double dt = t - s->last_t;
+  if (dt <= 0)
+    return;
+
+  if (s->adaptive)
+    tqdm_ema_tune(s, (n - s->last_n) / dt);
+
+  s->dn = s->alpha * (n - s->last_n) + (1 - s->alpha) * s->dn;
+  s->dt = s->alpha * dt + (1 - s->alpha) * s->dt;
+  s->weight = s->alpha + (1 - s->alpha) * s->weight;
+  s->last_t = t;
+  s->last_n = n;
+}
+
+static double tqdm_ema_rate(const tqdm_estimator_state_t *state) {
+  const tqdm_ema_state_t *s = (const tqdm_ema_state_t *)state;
+  /* The bias corrections of dn and dt cancel out in the ratio */
+  return s->weight > 0 && s->dt > 0 ? s->dn / s->dt : 0.0;
+}
+
+const tqdm_estimator_t tqdm_estimator_ema = {
+    "ema", tqdm_ema_reset, tqdm_ema_sample, tqdm_ema_rate};
+
+/* Exponentially weighted least squares over the last TQDM_LINREG_WINDOW
+ * (t, n) samples; the rate is the slope. Sums are updated in O(1) per
+ * sample (decay, add the new point, drop the one leaving the ring) and
+ * recomputed exactly once per lap to shed rounding drift.
+ *
+ * Samples are spaced at least max(0.5 s, elapsed / (4 * window)) apart,
+ * so the window spans about the last quarter of the run: long enough to
+ * ride out noise, short enough to forget a warmup phase. */
+#define TQDM_LINREG_WINDOW 16
+#define TQDM_LINREG_MIN_SPACING 0.5
+
+typedef struct {
+  double lambda;   /* Per-sample decay, from params.smoothing */
+  double lambda_w; /* lambda^TQDM_LINREG_WINDOW */
+  double sw, st, sn, stt, stn;
+  double t[TQDM_LINREG_WINDOW];
+  double n[TQDM_LINREG_WINDOW];
+  size_t next;     /* Ring slot for the next sample */
+  size_t count;
+} tqdm_linreg_state_t;
+TQDM_STATE_FITS(tqdm_linreg_state_t, linreg);
+
+static void tqdm_linreg_reset(tqdm_estimator_state_t *state,
+                              const tqdm_params_t *params) {
+  tqdm_linreg_state_t *s = (tqdm_linreg_state_t *)state;
+  memset(s, 0, sizeof(*s));
+
+  /* smoothing 0 weighs the window flat; larger favours recent samples */
+  double smoothing = params->smoothing;
+  if (smoothing < 0 || smoothing > 1)
+    smoothing = 0.3;
+  s->lambda = 1.0 - smoothing / 2;
+  s->lambda_w = pow(s->lambda, TQDM_LINREG_WINDOW);
+}
+
+static void tqdm_linreg_recompute(tqdm_linreg_state_t *s) {
+  s->sw = s->st = s->sn = s->stt = s->stn = 0;
+  double w = 1.0;
+  for (size_t age = 0; age < s->count; age++) {
+    size_t i = (s->next + TQDM_LINREG_WINDOW - 1 - age) % TQDM_LINREG_WINDOW;
+    s->sw += w;
+    s->st += w * s->t[i];
+    s->sn += w * s->n[i];
+    s->stt += w * s->t[i] * s->t[i];
+    s->stn += w * s->t[i] * s->n[i];
+    w *= s->lambda;
+  }
+}
+
+static void tqdm_linreg_sample(tqdm_estimator_state_t *state, double t,
+                               double n) {
+  tqdm_linreg_state_t *s = (tqdm_linreg_state_t *)state;
+
+  if (s->count > 0) {
+    double last = s->t[(s->next + TQDM_LINREG_WINDOW - 1) % TQDM_LINREG_WINDOW];
+    double spacing = t / (4 * TQDM_LINREG_WINDOW);
+    if (spacing < TQDM_LINREG_MIN_SPACING)
+      spacing = TQDM_LINREG_MIN_SPACING;
+    /* Too soon for a new point: the first two are let through so a rate
+     * is known early */
+    if (t - last < spacing && s->count >= 2)
+      return;
+    if (t <= last)
+      return;
+  }
+
+  s->sw *= s->lambda;
+  s->st *= s->lambda;
+  s->sn *= s->lambda;
+  s->stt *= s->lambda;
+  s->stn *= s->lambda;
+
+  if (s->count == TQDM_LINREG_WINDOW) {
+    double ot = s->t[s->next], on = s->n[s->next];
+    s->sw -= s->lambda_w;
+    s->st -= s->lambda_w * ot;
+    s->sn -= s->lambda_w * on;
+    s->stt -= s->lambda_w * ot * ot;
+    s->stn -= s->lambda_w * ot * on;
+  } else {
+    s->count++;
+  }
+
+  s->t[s->next] = t;
+  s->n[s->next] = n;
+  s->next = (s->next + 1) % TQDM_LINREG_WINDOW;
+
+  s->sw += 1;
+  s->st += t;
+  s->sn += n;
+  s->stt += t * t;
+  s->stn += t * n;
+
+  if (s->next == 0)
+    tqdm_linreg_recompute(s);
+}
+
+static double tqdm_linreg_rate(const tqdm_estimator_state_t *state) {
+  const tqdm_linreg_state_t *s = (const tqdm_linreg_state_t *)state;
+  if (s->count < 2)
+    return 0.0;
+
+  double denom = s->sw * s->stt - s->st * s->st;
+  if (denom <= 1e-12 * s->sw * s->stt)
+    return 0.0;
+  double slope = (s->sw * s->stn - s->st * s->sn) / denom;
+  return slope > 0 ? slope : 0.0;
+}
+
+const tqdm_estimator_t tqdm_estimator_linreg = {
+    "linreg", tqdm_linreg_reset, tqdm_linreg_sample, tqdm_linreg_rate};
+
+/* =============================
+ * Streaming quantiles
+ * =============================
+ * Jain and Chlamtac's P^2: five markers track the minimum, the p/2, p and
+ * (1+p)/2 quantiles and the maximum. Each sample moves the markers'
+ * positions, and a marker that drifts a whole position from where it
+ * should be is nudged along a parabola through its neighbours. */
+void tqdm_quantile_init(tqdm_quantile_t *qt, double p) {
+  memset(qt, 0, sizeof(*qt));
+  qt->p = p;
+  for (int i = 0; i < 5; i++)
+    qt->pos[i] = i + 1;
+  qt->want[0] = 1;
+  qt->want[1] = 1 + 2 * p;
+  qt->want[2] = 1 + 4 * p;
+  qt->want[3] = 3 + 2 * p;
+  qt->want[4] = 5;
+}
+
+static double tqdm_quantile_parabolic(const tqdm_quantile_t *qt, int i,
+                                      double d) {
+  const double *q = qt->q, *n = qt->pos;
+  return q[i] + d / (n[i + 1] - n[i - 1]) *
+                    ((n[i] - n[i - 1] + d) * (q[i + 1] - q[i]) /
+                         (n[i + 1] - n[i]) +
+                     (n[i + 1] - n[i] - d) * (q[i] - q[i - 1]) /
+                         (n[i] - n[i - 1]));
+}
+
+void tqdm_quantile_add(tqdm_quantile_t *qt, double x) {
+  /* The first five are kept sorted and become the markers */
+  if (qt->count < 5) {
+    size_t i = qt->count++;
+    while (i > 0 && qt->q[i - 1] > x) {
+      qt->q[i] = qt->q[i - 1];
+      i--;
+    }
+    qt->q[i] = x;
+    return;
+  }
+  qt->count++;
+
+  int k;
+  if (x < qt->q[0]) {
+    qt->q[0] = x;
+    k = 0;
+  } else if (x >= qt->q[4]) {
+    qt->q[4] = x;
+    k = 3;
+  } else {
+    for (k = 0; x >= qt->q[k + 1]; k++)
+      ;
+  }
+
+  const double step[5] = {0, qt->p / 2, qt->p, (1 + qt->p) / 2, 1};
+  for (int i = 0; i < 5; i++) {
+    if (i > k)
+      qt->pos[i] += 1;
+    qt->want[i] += step[i];
+  }
+
+  for (int i = 1; i < 4; i++) {
+    double d = qt->want[i] - qt->pos[i];
+    if ((d < 1 || qt->pos[i + 1] - qt->pos[i] <= 1) &&
+        (d > -1 || qt->pos[i - 1] - qt->pos[i] >= -1))
+      continue;
+
+    int s = d > 0 ? 1 : -1;
+    double q = tqdm_quantile_parabolic(qt, i, s);
+    if (q <= qt->q[i - 1] || q >= qt->q[i + 1])
+      q = qt->q[i] + s * (qt->q[i + s] - qt->q[i]) /
+                         (qt->pos[i + s] - qt->pos[i]);
+    qt->q[i] = q;
+    qt->pos[i] += s;
+  }
+}
+
+double tqdm_quantile_value(const tqdm_quantile_t *qt) {
+  if (qt->count < TQDM_QUANTILE_MIN_SAMPLES)
+    return -1.0;
+  if (qt->count > 5)
+    return qt->q[2];
+
+  /* Exact, from the sorted samples */
+  double pos = qt->p * (qt->count - 1);
+  size_t i = (size_t)pos;
+  if (i + 1 >= qt->count)
+    return qt->q[qt->count - 1];
+  return qt->q[i] + (qt->q[i + 1] - qt->q[i]) * (pos - i);
+}
+
+/* =============================
+ * Rate change detection
+ * =============================
+ * Page-Hinkley, two-sided: each interval's deviation from the regime's
+ * mean, in standard deviations less a drift allowance, accumulates as
+ * evidence of a rise or a drop and is forgotten when it goes negative.
+ * Noise cancels out; a real shift piles up past the threshold in two
+ * intervals. One interval alone cannot get there, so a lone outlier is
+ * not taken for a shift. Steady rates have their spread floored at a
+ * fraction of the mean so that jitter is not news. */
+#define TQDM_CHANGE_MIN_COUNT 5     /* Intervals before a regime can end */
+#define TQDM_CHANGE_DRIFT 0.5       /* Deviations tolerated per interval */
+#define TQDM_CHANGE_MAX_STEP 4.0    /* Evidence one interval can add */
+#define TQDM_CHANGE_THRESHOLD 5.0
+#define TQDM_CHANGE_MIN_SPREAD 0.05 /* Of the mean */
+
+void tqdm_change_reset(tqdm_change_t *c) { memset(c, 0, sizeof(*c)); }
+
+bool tqdm_change_add(tqdm_change_t *c, double x) {
+  if (c->count >= TQDM_CHANGE_MIN_COUNT) {
+    double spread = sqrt(c->m2 / (c->count - 1));
+    if (spread < TQDM_CHANGE_MIN_SPREAD * fabs(c->mean))
+      spread = TQDM_CHANGE_MIN_SPREAD * fabs(c->mean);
+    if (spread < 1e-12)
+      spread = 1e-12;
+
+    double z = fmax(-TQDM_CHANGE_MAX_STEP,
+                    fmin(TQDM_CHANGE_MAX_STEP, (x - c->mean) / spread));
+    c->up = fmax(0.0, c->up + z - TQDM_CHANGE_DRIFT);
+    c->down = fmax(0.0, c->down - z - TQDM_CHANGE_DRIFT);
+    if (c->up > TQDM_CHANGE_THRESHOLD || c->down > TQDM_CHANGE_THRESHOLD)
+      return true;
+  }
+
+  c->count++;
+  double diff = x - c->mean;
+  c->mean += diff / c->count;
+  c->m2 += diff * (x - c->mean);
+  return false;
+}
+
+const tqdm_estimator_t *tqdm_estimator_find(const char *name) {
+  static const tqdm_estimator_t *const builtins[] = {
+      &tqdm_estimator_avg, &tqdm_estimator_ema, &tqdm_estimator_linreg};
+
+  for (size_t i = 0; name && i < sizeof(builtins) / sizeof(builtins[0]); i++) {
+    if (strcmp(builtins[i]->name, name) == 0)
+      return builtins[i];
+  }
+  return NULL;
+}
@@ -0,0 +1,360 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tqdm_internal.h"
+
+/* =============================
+ * Dashboard groups
+ * =============================
+ * A frame is a fixed block: the aggregate bar, then `rows` member bars.
+ * Picking the members is a scan over their counters; only the rows that
+ * are shown get formatted, so drawing cost does not grow with the group.
+ */
+#define TQDM_GROUP_ROW_SIZE 1024
+
+typedef struct {
+  tqdm_t *bar;
+  double key;                 /* Larger sorts first */
+} tqdm_group_pick_t;
+
+struct tqdm_group_s {
+  pthread_mutex_t lock;
+  tqdm_style_t *style;        /* Look of the aggregate row */
+  char *desc;                 /* Aggregate row description */
+  FILE *file;
+  float mininterval;
+  int ncols;
+  size_t rows;                /* Member rows under the aggregate */
+  tqdm_group_order_t order;
+  double stall_after;
+
+  tqdm_t **members;
+  size_t nmembers;
+  size_t cap;
+
+  /* Members that have left the group */
+  size_t retired_n;
+  size_t retired_total;
+  size_t retired_done;
+  bool retired_open_total;    /* A retired member had no total */
+
+  double start_time;
+  double last_draw;
+  size_t drawn_rows;          /* Rows on screen from the previous frame */
+  bool closed;
+  bool muted;                 /* Output is /dev/null or gone */
+
+  tqdm_group_pick_t *picks;   /* Members shown in the current frame */
+  char *frame;                /* Whole frame, written with one fwrite */
+  size_t frame_size;
+};
+
+tqdm_group_t *tqdm_group_create(const tqdm_params_t *params, size_t rows,
+                                tqdm_group_order_t order,
+                                double stall_after) {
+  tqdm_params_t tpl = params ? *params : tqdm_static_default_params();
+
+  tqdm_group_t *group = calloc(1, sizeof(*group));
+  if (!group)
+    return NULL;
+
+  group->style = tqdm_style_create(&tpl);
+  group->desc = tpl.desc ? strdup(tpl.desc) : NULL;
+  group->frame_size = (rows + 1) * TQDM_GROUP_ROW_SIZE;
+  group->frame = malloc(group->frame_size);
+  group->picks = calloc(rows ? rows : 1, sizeof(*group->picks));
+  if (!group->style || (tpl.desc && !group->desc) || !group->frame ||
+      !group->picks) {
+    tqdm_style_release(group->style);
+    free(group->desc);
+    free(group->frame);
+    free(group->picks);
+    free(group);
+    return NULL;
+  }
+
+  pthread_mutex_init(&group->lock, NULL);
+  group->file = tpl.file ? tpl.file : stderr;
+  group->mininterval = tpl.mininterval >= 0 ? tpl.mininterval : 0.1f;
+  group->ncols = tpl.ncols;
+  group->rows = rows;
+  group->order = order;
+  group->stall_after = stall_after > 0 ? stall_after : 10.0;
+  group->start_time = current_time_seconds();
+  group->muted = tqdm_output_discarded(group->file);
+  return group;
+}
+
+bool tqdm_group_add(tqdm_group_t *group, tqdm_t *tqdm) {
+  if (!group || !tqdm || tqdm->group)
+    return false;
+
+  pthread_mutex_lock(&group->lock);
+  if (group->nmembers == group->cap) {
+    size_t cap = group->cap ? group->cap * 2 : 16;
+    tqdm_t **members = realloc(group->members, cap * sizeof(*members));
+    if (!members) {
+      pthread_mutex_unlock(&group->lock);
+      return false;
+    }
+    group->members = members;
+    group->cap = cap;
+  }
+  group->members[group->nmembers++] = tqdm;
+  pthread_mutex_unlock(&group->lock);
+
+  /* The member's own output no longer matters */
+  pthread_mutex_lock(&tqdm->lock);
+  tqdm->group = group;
+  tqdm->muted = false;
+  pthread_mutex_unlock(&tqdm->lock);
+  return true;
+}
+
+static bool tqdm_group_member_done(const tqdm_t *tqdm, size_t n,
+                                   size_t total) {
+  return tqdm->closed || (total > 0 && n >= total);
+}
+
+/* The member's final counts stay in the aggregate. Its lock comes before
+ * the group's, as in tqdm_group_destroy, so the owner never sees group or
+ * muted change mid-frame. */
+void tqdm_group_remove(tqdm_group_t *group, tqdm_t *tqdm) {
+  if (!group || !tqdm)
+    return;
+
+  pthread_mutex_lock(&tqdm->lock);
+  pthread_mutex_lock(&group->lock);
+  for (size_t i = 0; i < group->nmembers; i++) {
+    if (group->members[i] != tqdm)
+      continue;
+
+    size_t n = __atomic_load_n(&tqdm->n, __ATOMIC_RELAXED);
+    size_t total = tqdm_live_total(tqdm);
+    group->retired_n += n;
+    group->retired_total += total;
+    group->retired_open_total |= total == 0;
+    group->retired_done += tqdm_group_member_done(tqdm, n, total);
+    group->members[i] = group->members[--group->nmembers];
+    break;
+  }
+  tqdm->group = NULL;
+  tqdm->muted = tqdm_output_discarded(tqdm->params.file);
+  pthread_mutex_unlock(&group->lock);
+  pthread_mutex_unlock(&tqdm->lock);
+}
+
+/* Sort key for the member rows */
+static double tqdm_group_key(const tqdm_group_t *group, const tqdm_t *tqdm,
+                             size_t n, double now) {
+  if (group->order == TQDM_GROUP_RECENT)
+    return tqdm_live_progress_time(tqdm);
+
+  /* Estimated seconds left; unknown (no rate or no total) sorts first */
+  double elapsed = tqdm_live_elapsed(tqdm, now);
+  size_t total = tqdm_live_total(tqdm);
+  if (n == 0 || elapsed <= 0 || total == 0)
+    return INFINITY;
+  return (total - n) * elapsed / n;
+}
+
+/* Keep the `max` largest keys, sorted, by insertion */
+static void tqdm_group_pick(tqdm_group_pick_t *picks, size_t *npicks,
+                            size_t max, tqdm_t *bar, double key) {
+  size_t i;
+  if (*npicks < max)
+    i = (*npicks)++;
+  else if (max > 0 && key > picks[max - 1].key)
+    i = max - 1;
+  else
+    return;
+
+  while (i > 0 && picks[i - 1].key < key) {
+    picks[i] = picks[i - 1];
+    i--;
+  }
+  picks[i].bar = bar;
+  picks[i].key = key;
+}
+
+static size_t tqdm_group_put(tqdm_group_t *group, size_t len,
+                             const char *s) {
+  size_t slen = strlen(s);
+  if (slen > group->frame_size - 1 - len)
+    slen = group->frame_size - 1 - len;
+  memcpy(group->frame + len, s, slen);
+  return len + slen;
+}
+
+/* Draw one frame. Called with the group lock held; `from` is a member
+ * whose lock the caller holds (or NULL). */
+static void tqdm_group_draw(tqdm_group_t *group, tqdm_t *from, bool final) {
+  if (group->muted)
+    return;
+
+  double now = current_time_seconds();
+  int ncols = group->ncols > 0 ? group->ncols : get_terminal_width();
+
+  size_t n = group->retired_n;
+  size_t total = group->retired_total;
+  bool open_total = group->retired_open_total;
+  size_t done = group->retired_done, active = 0, stalled = 0;
+
+  tqdm_group_pick_t *picks = group->picks;
+  size_t npicks = 0;
+
+  for (size_t i = 0; i < group->nmembers; i++) {
+    tqdm_t *bar = group->members[i];
+    size_t bar_n = __atomic_load_n(&bar->n, __ATOMIC_RELAXED);
+    size_t bar_total = tqdm_live_total(bar);
+
+    n += bar_n;
+    total += bar_total;
+    open_total |= bar_total == 0;
+
+    if (tqdm_group_member_done(bar, bar_n, bar_total)) {
+      done++;
+      continue;
+    }
+    if (now - tqdm_live_progress_time(bar) > group->stall_after)
+      stalled++;
+    else
+      active++;
+    tqdm_group_pick(picks, &npicks, group->rows, bar,
+                    tqdm_group_key(group, bar, bar_n, now));
+  }
+
+  size_t len = 0;
+  char line[32];
+  if (group->drawn_rows > 1) {
+    snprintf(line, sizeof(line), "\033[%zuA", group->drawn_rows - 1);
+    len = tqdm_group_put(group, len, line);
+  }
+
+  /* Aggregate row, with the counts as its postfix */
+  char counts[96];
+  snprintf(counts, sizeof(counts), "done=%zu active=%zu stalled=%zu", done,
+           active, stalled);
+  double elapsed = now - group->start_time;
+  double rate = elapsed > 1e-6 ? n / elapsed : 0.0;
+  if (open_total)
+    total = 0;
+  tqdm_meter_t meter = {
+      .n = n,
+      .total = total,
+      .total_estimate = total,
+      .elapsed = elapsed,
+      .rate = rate,
+      .remaining = (total > 0 && n > 0 && rate > 0 && n < total)
+                       ? (total - n) / rate
+                       : -1.0,
+      .desc = group->desc,
+      .postfix = counts,
+      .ncols = ncols,
+  };
+  len = tqdm_group_put(group, len, "\r\033[K");
+  len += tqdm_render_meter(group->frame + len, group->frame_size - len,
+                           &meter, group->style);
+
+  /* Member rows. A member busy in another thread is drawn from its
+   * counters alone, in its style or the group's, rather than waited for. */
+  for (size_t r = 0; r < group->rows; r++) {
+    len = tqdm_group_put(group, len, "\n\r\033[K");
+    if (r >= npicks)
+      continue;
+
+    tqdm_t *bar = picks[r].bar;
+    bool locked = bar == from || pthread_mutex_trylock(&bar->lock) == 0;
+
+    tqdm_style_t local;
+    const tqdm_style_t *style;
+    if (locked) {
+      tqdm_sample_meter(bar, now, ncols, &meter);
+      style = tqdm_bar_style(bar, &local);
+    } else {
+      tqdm_sample_counters(bar, now, ncols, &meter);
+      style = bar->style ? bar->style : group->style;
+    }
+    len += tqdm_render_meter(group->frame + len, group->frame_size - len,
+                             &meter, style);
+
+    if (locked && bar != from)
+      pthread_mutex_unlock(&bar->lock);
+  }
+
+  if (final)
+    len = tqdm_group_put(group, len, "\n");
+
+  fwrite(group->frame, 1, len, group->file);
+  if (!tqdm_output_flush(group->file))
+    group->muted = true;
+
+  group->drawn_rows = final ? 0 : group->rows + 1;
+  group->last_draw = now;
+}
+
+void tqdm_group_notify(tqdm_group_t *group, tqdm_t *from) {
+  if (pthread_mutex_trylock(&group->lock) != 0)
+    return;
+  if (!group->closed &&
+      current_time_seconds() - group->last_draw >= group->mininterval)
+    tqdm_group_draw(group, from, false);
+  pthread_mutex_unlock(&group->lock);
+}
+
+void tqdm_group_refresh(tqdm_group_t *group) {
+  if (!group)
+    return;
+
+  pthread_mutex_lock(&group->lock);
+  if (!group->closed)
+    tqdm_group_draw(group, NULL, false);
+  pthread_mutex_unlock(&group->lock);
+}
+
+/* Draw the final frame and leave it on screen */
+void tqdm_group_close(tqdm_group_t *group) {
+  if (!group)
+    return;
+
+  pthread_mutex_lock(&group->lock);
+  if (!group->closed) {
+    tqdm_group_draw(group, NULL, true);
+    group->closed = true;
+  }
+  pthread_mutex_unlock(&group->lock);
+}
+
+void tqdm_group_destroy(tqdm_group_t *group) {
+  if (!group)
+    return;
+
+  tqdm_group_close(group);
+
+  /* Members still alive go back to drawing themselves. Their locks come
+   * before the group's, so the list is taken first and each member is
+   * detached under its own lock, as in tqdm_group_add. */
+  pthread_mutex_lock(&group->lock);
+  size_t nmembers = group->nmembers;
+  group->nmembers = 0;
+  pthread_mutex_unlock(&group->lock);
+
+  for (size_t i = 0; i < nmembers; i++) {
+    tqdm_t *bar = group->members[i];
+    pthread_mutex_lock(&bar->lock);
+    bar->group = NULL;
+    bar->muted = tqdm_output_discarded(bar->params.file);
+    pthread_mutex_unlock(&bar->lock);
+  }
+
+  pthread_mutex_destroy(&group->lock);
+  tqdm_style_release(group->style);
+  free(group->members);
+  free(group->desc);
+  free(group->frame);
+  free(group->picks);
+  free(group);
+}
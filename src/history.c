@@ -0,0 +1,361 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tqdm_internal.h"
+
+/* =============================
+ * Run history
+ * =============================
+ * With params.history_file set, a bar that runs to completion records its
+ * time profile (seconds elapsed at each tenth of the total) under a key
+ * made from desc and total. The next run with the same key starts from
+ * that profile as its ETA and hands over to the live estimate as it warms
+ * up.
+ *
+ * The file is text, one entry per line: key, run count, then the
+ * TQDM_HISTORY_MARKS elapsed times. Readers never lock: writers rewrite it
+ * into a temporary and rename() that over it, serialised by flock() on a
+ * "<file>.lock" next to it, so concurrent jobs neither tear nor lose
+ * entries.
+ */
+#define TQDM_HISTORY_MAX_ENTRIES 256
+#define TQDM_HISTORY_LINE_SIZE 512
+/* Later runs count for at least 1/TQDM_HISTORY_KEEP, so the prior follows
+ * jobs that slowly grow */
+#define TQDM_HISTORY_KEEP 4
+/* The live estimate takes over at this fraction of the run (or of the
+ * previous run's duration) */
+#define TQDM_HISTORY_WARMUP 0.1
+
+uint64_t tqdm_history_key(const char *desc, size_t total, size_t cost_total) {
+  uint64_t h = 14695981039346656037ULL; /* FNV-1a */
+  const unsigned char *p = (const unsigned char *)(desc ? desc : "");
+
+  for (; *p; p++)
+    h = (h ^ *p) * 1099511628211ULL;
+  for (int i = 0; i < 2; i++) {
+    uint64_t v = i == 0 ? total : cost_total;
+    for (int b = 0; b < 8; b++, v >>= 8)
+      h = (h ^ (v & 0xff)) * 1099511628211ULL;
+  }
+  return h;
+}
+
+/* One line: "<key> <runs> <mark>..." */
+static bool tqdm_history_parse(const char *line, uint64_t *key,
+                               unsigned *runs, float *marks) {
+  char *end;
+  unsigned long long k = strtoull(line, &end, 16);
+  if (end == line)
+    return false;
+  unsigned long r = strtoul(end, &end, 10);
+
+  for (int i = 0; i < TQDM_HISTORY_MARKS; i++) {
+    const char *from = end;
+    marks[i] = strtof(from, &end);
+    if (end == from || marks[i] < 0 || (i > 0 && marks[i] < marks[i - 1]))
+      return false;
+  }
+  *key = k;
+  *runs = (unsigned)r;
+  return marks[TQDM_HISTORY_MARKS - 1] > 0;
+}
+
+bool tqdm_history_load(const char *path, uint64_t key, float *marks) {
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return false;
+
+  char line[TQDM_HISTORY_LINE_SIZE];
+  bool found = false;
+  while (!found && fgets(line, sizeof(line), f)) {
+    uint64_t k;
+    unsigned runs;
+    float m[TQDM_HISTORY_MARKS];
+    if (tqdm_history_parse(line, &k, &runs, m) && k == key) {
+      memcpy(marks, m, sizeof(m));
+      found = true;
+    }
+  }
+  fclose(f);
+  return found;
+}
+
+/* Lines of the current file, read whole (the file is small by design) */
+typedef struct {
+  char *data;
+  char **lines;
+  size_t nlines;
+} tqdm_history_file_t;
+
+static bool tqdm_history_read(const char *path, tqdm_history_file_t *hf) {
+  hf->data = NULL;
+  hf->lines = NULL;
+  hf->nlines = 0;
+
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return errno == ENOENT;
+
+  size_t cap = TQDM_HISTORY_LINE_SIZE, len = 0;
+  hf->data = malloc(cap);
+  char line[TQDM_HISTORY_LINE_SIZE];
+  while (hf->data && fgets(line, sizeof(line), f)) {
+    size_t n = strlen(line);
+    if (len + n + 1 > cap) {
+      char *data = realloc(hf->data, cap *= 2);
+      if (!data) {
+        free(hf->data);
+        hf->data = NULL;
+        break;
+      }
+      hf->data = data;
+    }
+    memcpy(hf->data + len, line, n + 1);
+    len += n;
+  }
+  fclose(f);
+  if (!hf->data)
+    return false;
+
+  /* Split in place; lines longer than the buffer were split by fgets and
+   * fail to parse, so they are dropped on rewrite */
+  size_t count = 1;
+  for (const char *p = hf->data; *p; p++)
+    count += *p == '\n';
+  hf->lines = malloc(count * sizeof(*hf->lines));
+  if (!hf->lines) {
+    free(hf->data);
+    return false;
+  }
+  for (char *p = hf->data; *p;) {
+    char *nl = strchr(p, '\n');
+    hf->lines[hf->nlines++] = p;
+    if (!nl)
+      break;
+    *nl = '\0';
+    p = nl + 1;
+  }
+  return true;
+}
+
+static void tqdm_history_file_free(tqdm_history_file_t *hf) {
+  free(hf->data);
+  free(hf->lines);
+}
+
+static void tqdm_history_write_entry(FILE *f, uint64_t key, unsigned runs,
+                                     const float *marks) {
+  fprintf(f, "%016llx %u", (unsigned long long)key, runs);
+  for (int i = 0; i < TQDM_HISTORY_MARKS; i++)
+    fprintf(f, " %.6g", marks[i]);
+  fputc('\n', f);
+}
+
+bool tqdm_history_store(const char *path, uint64_t key, const float *marks) {
+  size_t plen = strlen(path);
+  char *lock_path = malloc(plen + sizeof(".lock"));
+  char *tmp_path = malloc(plen + sizeof(".XXXXXX"));
+  if (!lock_path || !tmp_path) {
+    free(lock_path);
+    free(tmp_path);
+    return false;
+  }
+  memcpy(lock_path, path, plen);
+  memcpy(lock_path + plen, ".lock", sizeof(".lock"));
+  memcpy(tmp_path, path, plen);
+  memcpy(tmp_path + plen, ".XXXXXX", sizeof(".XXXXXX"));
+
+  bool ok = false;
+  int lock_fd = open(lock_path, O_RDWR | O_CREAT, 0644);
+  if (lock_fd < 0 || flock(lock_fd, LOCK_EX) != 0)
+    goto out;
+
+  tqdm_history_file_t hf;
+  if (!tqdm_history_read(path, &hf))
+    goto out;
+
+  /* mkstemp creates the file 0600; the history is not private */
+  int tmp_fd = mkstemp(tmp_path);
+  if (tmp_fd >= 0)
+    fchmod(tmp_fd, 0644);
+  FILE *tmp = tmp_fd >= 0 ? fdopen(tmp_fd, "w") : NULL;
+  if (!tmp) {
+    if (tmp_fd >= 0)
+      close(tmp_fd);
+    tqdm_history_file_free(&hf);
+    goto out;
+  }
+
+  /* Keep the other entries, oldest first, and move ours to the end */
+  float merged[TQDM_HISTORY_MARKS];
+  unsigned runs = 0;
+  size_t kept = 0, skip = 0;
+  for (size_t i = 0; i < hf.nlines; i++) {
+    uint64_t k;
+    unsigned r;
+    float m[TQDM_HISTORY_MARKS];
+    if (tqdm_history_parse(hf.lines[i], &k, &r, m) && k != key)
+      kept++;
+  }
+  if (kept >= TQDM_HISTORY_MAX_ENTRIES)
+    skip = kept - TQDM_HISTORY_MAX_ENTRIES + 1;
+
+  memcpy(merged, marks, sizeof(merged));
+  for (size_t i = 0; i < hf.nlines; i++) {
+    uint64_t k;
+    unsigned r;
+    float m[TQDM_HISTORY_MARKS];
+    if (!tqdm_history_parse(hf.lines[i], &k, &r, m))
+      continue;
+    if (k == key) {
+      runs = r;
+      float weight = 1.0f / (r + 1 < TQDM_HISTORY_KEEP ? r + 1
+                                                       : TQDM_HISTORY_KEEP);
+      for (int j = 0; j < TQDM_HISTORY_MARKS; j++)
+        merged[j] = m[j] + (marks[j] - m[j]) * weight;
+    } else if (skip > 0) {
+      skip--;
+    } else {
+      fprintf(tmp, "%s\n", hf.lines[i]);
+    }
+  }
+  tqdm_history_write_entry(tmp, key, runs + 1, merged);
+  tqdm_history_file_free(&hf);
+
+  ok = fflush(tmp) == 0 && fsync(fileno(tmp)) == 0;
+  ok = fclose(tmp) == 0 && ok;
+  if (ok)
+    ok = rename(tmp_path, path) == 0;
+  if (!ok)
+    unlink(tmp_path);
+
+out:
+  if (lock_fd >= 0)
+    close(lock_fd); /* Releases the flock */
+  free(lock_path);
+  free(tmp_path);
+  return ok;
+}
+
+/* Progress as a fraction of the total, in cost for weighted bars; < 0
+ * when the total is unknown */
+static double tqdm_history_fraction(const tqdm_t *tqdm) {
+  size_t n = tqdm->weighted ? tqdm->cost : tqdm->n;
+  size_t total =
+      tqdm->weighted ? tqdm->params.cost_total : tqdm_live_total(tqdm);
+  if (total == 0)
+    return -1.0;
+  return n >= total ? 1.0 : (double)n / total;
+}
+
+/* The run state is allocated here, so bars without a history_file carry
+ * only the pointer. Without memory for it the run goes unrecorded. A
+ * prior read for another key (desc changed meanwhile) is not used. */
+void tqdm_history_begin(tqdm_t *tqdm, const tqdm_history_prior_t *prior) {
+  tqdm_history_run_t *h = tqdm->history;
+  if (!tqdm->params.history_file) {
+    free(h);
+    tqdm->history = NULL;
+    return;
+  }
+  if (!h && !(h = tqdm->history = malloc(sizeof(*h))))
+    return;
+
+  memset(h, 0, sizeof(*h));
+  h->key = tqdm_history_key(tqdm->params.desc, tqdm_live_total(tqdm),
+                            tqdm->params.cost_total);
+  if (!prior) {
+    h->prior_valid =
+        tqdm_history_load(tqdm->params.history_file, h->key, h->prior);
+  } else if (prior->valid && prior->key == h->key) {
+    memcpy(h->prior, prior->marks, sizeof(h->prior));
+    h->prior_valid = true;
+  }
+  tqdm_history_sample(tqdm, 0.0);
+}
+
+void tqdm_history_end(tqdm_t *tqdm) {
+  free(tqdm->history);
+  tqdm->history = NULL;
+}
+
+/* Record when each tenth of the total was passed, interpolating between
+ * refreshes */
+void tqdm_history_sample(tqdm_t *tqdm, double t) {
+  tqdm_history_run_t *h = tqdm->history;
+  if (!h)
+    return;
+  double f = tqdm_history_fraction(tqdm);
+  if (f < 0)
+    return;
+
+  while (h->next < TQDM_HISTORY_MARKS) {
+    double target = (double)h->next / (TQDM_HISTORY_MARKS - 1);
+    if (f < target - 1e-9)
+      break;
+    double at = t;
+    if (f > h->last_f)
+      at = h->last_t + (t - h->last_t) * (target - h->last_f) /
+                           (f - h->last_f);
+    h->marks[h->next++] = (float)at;
+  }
+  h->last_t = t;
+  h->last_f = f;
+}
+
+/* The profile of a run that reached its total, to be stored */
+bool tqdm_history_finish(tqdm_t *tqdm, double t, uint64_t *key,
+                         float *marks) {
+  if (!tqdm->history)
+    return false;
+  tqdm_history_sample(tqdm, t);
+  if (tqdm->history->next < TQDM_HISTORY_MARKS)
+    return false;
+  *key = tqdm->history->key;
+  memcpy(marks, tqdm->history->marks, sizeof(tqdm->history->marks));
+  return true;
+}
+
+/* Seconds into the previous runs' profile at a fraction of the total */
+static double tqdm_history_at(const float *m, double fraction) {
+  if (fraction >= 1)
+    return m[TQDM_HISTORY_MARKS - 1];
+  double pos = fraction * (TQDM_HISTORY_MARKS - 1);
+  int i = (int)pos;
+  return m[i] + (m[i + 1] - m[i]) * (pos - i);
+}
+
+double tqdm_history_span(const tqdm_t *tqdm, double from, double to) {
+  const tqdm_history_run_t *h = tqdm->history;
+  if (!h || !h->prior_valid || from < 0 || to < from)
+    return -1.0;
+  return tqdm_history_at(h->prior, to) - tqdm_history_at(h->prior, from);
+}
+
+double tqdm_history_remaining(const tqdm_t *tqdm, double fraction,
+                              double elapsed, double live) {
+  if (!tqdm->history || !tqdm->history->prior_valid || fraction < 0 ||
+      fraction >= 1)
+    return live;
+
+  const float *m = tqdm->history->prior;
+  double prior = tqdm_history_span(tqdm, fraction, 1.0);
+  if (live < 0)
+    return prior;
+
+  /* Hand over to the live estimate as this run warms up */
+  double w = fraction / TQDM_HISTORY_WARMUP;
+  double by_time = elapsed / (TQDM_HISTORY_WARMUP * m[TQDM_HISTORY_MARKS - 1]);
+  if (by_time > w)
+    w = by_time;
+  if (w > 1)
+    w = 1;
+  return w * live + (1 - w) * prior;
+}
@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include "tqdm/tqdm.h"
@@ -17,8 +18,10 @@
 static void print_version(void) { puts("tqdm " VERSION); }
 
 static void print_help(void) {
-  puts("Usage: tqdm [OPTIONS]\n"
-       "Monitor progress of data through a pipe.\n\n"
+  puts("Usage: tqdm [OPTIONS] [FILE...]\n"
+       "Monitor progress of data through a pipe.\n"
+       "With FILEs, they are read in turn instead of stdin and progress is\n"
+       "weighted by their sizes: one item per file, rate and ETA in bytes.\n\n"
        "Core Options:\n"
        "  --desc=DESC               Prefix for the progress bar\n"
        "  --total=N                 Total expected items/bytes\n"
@@ -33,14 +36,16 @@ static void print_help(void) {
        "  --unit=UNIT               Unit text (default: it)\n"
        "  --unit-scale              Auto-scale units\n"
        "  --dynamic-ncols           Dynamically resize bar width\n"
-       "  --smoothing=F             Rate smoothing factor\n"
+       "  --smoothing=F             Rate smoothing factor, or 'auto'\n"
        "  --bar-format=FMT          Custom bar format string\n"
        "  --initial=N               Initial counter value\n"
        "  --position=N              Line position for multi-bars\n"
        "  --postfix=STR             Postfix string\n"
        "  --unit-divisor=N          Unit divisor (1000/1024)\n"
        "  --colour=COLOR            Progress bar colour\n"
-       "  --delay=F                 Initial delay before showing (s)\n\n"
+       "  --delay=F                 Initial delay before showing (s)\n"
+       "  --history-file=PATH       Start the ETA from earlier runs with the\n"
+       "                            same desc and total\n\n"
        "Advanced Options:\n"
        "  --bytes                   Bytes mode (unit=B, scaled)\n"
        "  --delim=CHAR              Delimiter for text mode (default: \n)\n"
@@ -65,6 +70,8 @@ typedef struct {
   bool update;     /* Incremental numeric updates              */
   bool update_to;  /* Absolute numeric updates                 */
   bool null_ok;    /* Allow NUL bytes in tee output            */
+  char **files;    /* Inputs for multi-file mode, or NULL      */
+  int nfiles;
 } processing_opts_t;
 
 static processing_opts_t proc_default(void) {
@@ -77,8 +84,7 @@ static processing_opts_t proc_default(void) {
 static tqdm_params_t parse_args(int argc, char **argv,
                                 processing_opts_t *popts) {
   *popts = proc_default();
-  tqdm_params_t p = tqdm_default_params();
-  tqdm_load_env_vars(&p);
+  tqdm_params_t p = tqdm_default_params(); /* TQDM_* env already applied */
 
   static struct option long_opts[] = {
       /* Options */
@@ -103,6 +109,7 @@ static tqdm_params_t parse_args(int argc, char **argv,
       {"unit-divisor", required_argument, 0, 'v'},
       {"colour", required_argument, 0, 'C'},
       {"delay", required_argument, 0, 'y'},
+      {"history-file", required_argument, 0, 'H'},
       {"bytes", no_argument, 0, 'B'},
       {"delim", required_argument, 0, 'e'},
       {"buf-size", required_argument, 0, 'z'},
@@ -117,7 +124,7 @@ static tqdm_params_t parse_args(int argc, char **argv,
 
   int opt;
   while ((opt = getopt_long(argc, argv,
-                            "d:t:lLf:c:i:m:aDu:UNs:b:n:p:P:v:C:y:Be:z:TRSxhV",
+                            "d:t:lLf:c:i:m:aDu:UNs:b:n:p:P:v:C:y:H:Be:z:TRSxhV",
                             long_opts, NULL)) != -1) {
     switch (opt) {
     /* Options */
@@ -172,7 +179,8 @@ static tqdm_params_t parse_args(int argc, char **argv,
       p.dynamic_ncols = true;
       break;
     case 's':
-      p.smoothing = atof(optarg);
+      p.smoothing = strcmp(optarg, "auto") == 0 ? TQDM_SMOOTHING_AUTO
+                                                : atof(optarg);
       break;
     case 'b':
       free(p.bar_format);
@@ -198,6 +206,10 @@ static tqdm_params_t parse_args(int argc, char **argv,
     case 'y':
       p.delay = atof(optarg);
       break;
+    case 'H':
+      free(p.history_file);
+      p.history_file = strdup(optarg);
+      break;
     case 'B': /* bytes mode */
       p.unit_scale = true;
       p.unit_divisor = 1024.0f;
@@ -239,6 +251,12 @@ static tqdm_params_t parse_args(int argc, char **argv,
       exit(1);
     }
   }
+
+  /* Remaining arguments are input files */
+  if (optind < argc) {
+    popts->files = argv + optind;
+    popts->nfiles = argc - optind;
+  }
   return p;
 }
 
@@ -291,12 +309,79 @@ static size_t process_stream(tqdm_t *bar, FILE *in, processing_opts_t *o) {
   return processed;
 }
 
+/* Multi-file mode: each file is an item weighted by its size, so a few
+ * large files do not make the ETA meaningless. Sizes come from stat; if
+ * any input is not a regular file the byte total is left unknown. */
+static void files_setup(tqdm_params_t *p, const processing_opts_t *o) {
+  size_t bytes = 0;
+  bool sized = true;
+  for (int i = 0; i < o->nfiles; i++) {
+    struct stat st;
+    if (stat(o->files[i], &st) == 0 && S_ISREG(st.st_mode))
+      bytes += (size_t)st.st_size;
+    else
+      sized = false;
+  }
+
+  if (p->total == 0)
+    p->total = (size_t)o->nfiles;
+  p->cost_total = sized ? bytes : 0;
+
+  /* Rate and ETA are in bytes unless the user chose a unit */
+  if (!p->unit || !strcmp(p->unit, "it")) {
+    free(p->unit);
+    p->unit = strdup("B");
+    p->unit_scale = true;
+    p->unit_divisor = 1024.0f;
+  }
+}
+
+static size_t process_files(tqdm_t *bar, processing_opts_t *o) {
+  char *buf = malloc(o->buf_size);
+  if (!buf) {
+    perror("malloc");
+    return 0;
+  }
+  size_t processed = 0;
+  for (int i = 0; i < o->nfiles; i++) {
+    FILE *in = fopen(o->files[i], "rb");
+    if (!in) {
+      fprintf(stderr, "Failed to open %s: %s\n", o->files[i],
+              strerror(errno));
+      if (!o->update && !o->update_to)
+        tqdm_update_weighted(bar, 1, 0);
+      continue;
+    }
+
+    /* Numeric input modes count what the lines say, not the files */
+    if (o->update || o->update_to) {
+      processed += process_updates(bar, in, o);
+      fclose(in);
+      continue;
+    }
+
+    size_t read;
+    while ((read = fread(buf, 1, o->buf_size, in)) > 0) {
+      if (o->tee)
+        fwrite(buf, 1, read, stdout);
+      tqdm_update_weighted(bar, 0, read);
+      processed += read;
+    }
+    tqdm_update_weighted(bar, 1, 0);
+    fclose(in);
+  }
+  free(buf);
+  return processed;
+}
+
 /* =============================
  * Main function (Entry point)
  * ============================= */
 int main(int argc, char **argv) {
   processing_opts_t proc_opts;
   tqdm_params_t params = parse_args(argc, argv, &proc_opts);
+  if (proc_opts.nfiles > 0 && !proc_opts.update && !proc_opts.update_to)
+    files_setup(&params, &proc_opts);
 
   /* Create progress bar */
   tqdm_t *bar = tqdm_create_with_params(NULL, NULL, 1, &params);
@@ -306,11 +391,13 @@ int main(int argc, char **argv) {
   }
 
   FILE *input = stdin;
-  if (isatty(STDIN_FILENO))
+  if (proc_opts.nfiles == 0 && isatty(STDIN_FILENO))
     fputs("Reading from terminal (Ctrl+D to end)\n", stderr);
 
   size_t count = 0;
-  if (proc_opts.update || proc_opts.update_to)
+  if (proc_opts.nfiles > 0)
+    count = process_files(bar, &proc_opts);
+  else if (proc_opts.update || proc_opts.update_to)
     count = process_updates(bar, input, &proc_opts);
   else
     count = process_stream(bar, input, &proc_opts);
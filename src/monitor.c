@@ -0,0 +1,163 @@
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "tqdm_internal.h"
+
+/* =============================
+ * Monitor thread
+ * =============================
+ * Bars with a stall_timeout or an on_event callback are kept on a list
+ * that one background thread scans. It compares each bar's counter with
+ * what it saw last time, so the update path is untouched, and delivers
+ * the rate changes the renderer flagged. Callbacks run with the list
+ * unlocked; while one runs, tqdm_stop_monitor on that bar (from another
+ * thread) waits for it.
+ */
+#define TQDM_MONITOR_MAX_INTERVAL 1.0  /* Also the "STALLED 42s" tick */
+#define TQDM_MONITOR_MIN_INTERVAL 0.01
+
+static pthread_mutex_t tqdm_monitor_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t tqdm_monitor_cond = PTHREAD_COND_INITIALIZER;
+static tqdm_t *tqdm_monitor_bars;
+static bool tqdm_monitor_running;
+static pthread_t tqdm_monitor_tid;
+static tqdm_t *tqdm_monitor_busy; /* Bar whose callback is running */
+
+static void tqdm_monitor_unlink(tqdm_t *tqdm) {
+  for (tqdm_t **p = &tqdm_monitor_bars; *p; p = &(*p)->monitor_next) {
+    if (*p == tqdm) {
+      *p = tqdm->monitor_next;
+      break;
+    }
+  }
+  tqdm->monitor_next = NULL;
+  tqdm->monitored = false;
+}
+
+void tqdm_start_monitor(tqdm_t *tqdm) {
+  if (!tqdm || (tqdm->params.stall_timeout <= 0 && !tqdm->params.on_event))
+    return;
+
+  pthread_mutex_lock(&tqdm_monitor_lock);
+  if (tqdm->monitored) {
+    pthread_mutex_unlock(&tqdm_monitor_lock);
+    return;
+  }
+
+  tqdm->monitor_n = __atomic_load_n(&tqdm->n, __ATOMIC_RELAXED);
+  tqdm->monitor_progress_time = current_time_seconds();
+  tqdm->stalled = false;
+  tqdm->monitored = true;
+  tqdm->monitor_next = tqdm_monitor_bars;
+  tqdm_monitor_bars = tqdm;
+
+  if (!tqdm_monitor_running) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    tqdm_monitor_running = pthread_create(&tqdm_monitor_tid, &attr,
+                                          tqdm_monitor_thread, NULL) == 0;
+    pthread_attr_destroy(&attr);
+    if (!tqdm_monitor_running)
+      tqdm_monitor_unlink(tqdm); /* No thread: stalls go unnoticed */
+  } else {
+    /* A shorter timeout may need a shorter scan interval */
+    pthread_cond_broadcast(&tqdm_monitor_cond);
+  }
+  pthread_mutex_unlock(&tqdm_monitor_lock);
+}
+
+void tqdm_stop_monitor(tqdm_t *tqdm) {
+  if (!tqdm)
+    return;
+
+  pthread_mutex_lock(&tqdm_monitor_lock);
+  /* From inside its own callback the bar can go at once */
+  while (tqdm_monitor_busy == tqdm &&
+         !pthread_equal(pthread_self(), tqdm_monitor_tid))
+    pthread_cond_wait(&tqdm_monitor_cond, &tqdm_monitor_lock);
+  if (tqdm->monitored)
+    tqdm_monitor_unlink(tqdm);
+  tqdm->stalled = false;
+  pthread_mutex_unlock(&tqdm_monitor_lock);
+}
+
+/* Check one bar; returns the event to report, or -1 */
+static int tqdm_monitor_check(tqdm_t *tqdm, double now) {
+  size_t n = __atomic_load_n(&tqdm->n, __ATOMIC_RELAXED);
+  int event = -1;
+
+  if (n != tqdm->monitor_n) {
+    __atomic_store_n(&tqdm->monitor_n, n, __ATOMIC_RELAXED);
+    __atomic_store(&tqdm->monitor_progress_time, &now, __ATOMIC_RELAXED);
+    if (tqdm->stalled) {
+      __atomic_store_n(&tqdm->stalled, false, __ATOMIC_RELEASE);
+      event = TQDM_EVENT_RESUMED;
+    }
+  } else if (!tqdm->stalled && tqdm->params.stall_timeout > 0 &&
+             now - tqdm->monitor_progress_time >= tqdm->params.stall_timeout) {
+    __atomic_store_n(&tqdm->stalled, true, __ATOMIC_RELEASE);
+    event = TQDM_EVENT_STALLED;
+  }
+  /* One event per scan; a rate change waits for the next */
+  if (event < 0 &&
+      __atomic_exchange_n(&tqdm->rate_changed, false, __ATOMIC_ACQ_REL))
+    event = TQDM_EVENT_RATE_CHANGE;
+
+  /* Nothing else draws a stalled bar: keep its counter ticking. A bar
+   * whose lock is held is busy drawing (or hung); skip it this time. */
+  if ((tqdm->stalled || event >= 0) && !tqdm->closed &&
+      pthread_mutex_trylock(&tqdm->lock) == 0) {
+    tqdm_redraw_locked(tqdm);
+    pthread_mutex_unlock(&tqdm->lock);
+  }
+  return event;
+}
+
+void *tqdm_monitor_thread(void *arg) {
+  (void)arg;
+
+  pthread_mutex_lock(&tqdm_monitor_lock);
+  while (tqdm_monitor_bars) {
+    double now = current_time_seconds();
+    double interval = TQDM_MONITOR_MAX_INTERVAL;
+
+    for (tqdm_t *bar = tqdm_monitor_bars; bar; bar = bar->monitor_next) {
+      double quarter = bar->params.stall_timeout / 4;
+      if (quarter > 0 && quarter < interval)
+        interval = quarter;
+
+      int event = tqdm_monitor_check(bar, now);
+      if (event < 0 || !bar->params.on_event)
+        continue;
+
+      /* Run the callback unlocked, then rescan: the list may have
+       * changed, and the bar may be gone */
+      tqdm_monitor_busy = bar;
+      pthread_mutex_unlock(&tqdm_monitor_lock);
+      bar->params.on_event(bar, (tqdm_event_t)event,
+                           bar->params.on_event_data);
+      pthread_mutex_lock(&tqdm_monitor_lock);
+      tqdm_monitor_busy = NULL;
+      pthread_cond_broadcast(&tqdm_monitor_cond);
+      interval = 0;
+      break;
+    }
+    if (interval <= 0)
+      continue;
+    if (interval < TQDM_MONITOR_MIN_INTERVAL)
+      interval = TQDM_MONITOR_MIN_INTERVAL;
+
+    struct timespec until;
+    clock_gettime(CLOCK_REALTIME, &until);
+    double secs = until.tv_nsec / 1e9 + interval;
+    until.tv_sec += (time_t)secs;
+    until.tv_nsec = (long)((secs - floor(secs)) * 1e9);
+    pthread_cond_timedwait(&tqdm_monitor_cond, &tqdm_monitor_lock, &until);
+  }
+  tqdm_monitor_running = false;
+  pthread_mutex_unlock(&tqdm_monitor_lock);
+  return NULL;
+}
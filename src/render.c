@@ -0,0 +1,784 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "tqdm_internal.h"
+
+/* =============================
+ * Number and time formatting
+ * ============================= */
+static size_t tqdm_fmt_clamp(int len, size_t size) {
+  if (len < 0 || size == 0)
+    return 0;
+  return (size_t)len < size ? (size_t)len : size - 1;
+}
+
+size_t tqdm_fmt_sizeof(char *buf, size_t size, double num,
+                       const char *suffix, int divisor) {
+  static const char *prefixes[] = {"",  "k", "M", "G", "T",
+                                   "P", "E", "Z", "Y"};
+  int prefix_idx = 0;
+
+  if (divisor == 1024) {
+    while (num >= 1024.0 && prefix_idx < 8) {
+      num /= 1024.0;
+      prefix_idx++;
+    }
+  } else {
+    while (num >= divisor && prefix_idx < 8) {
+      num /= divisor;
+      prefix_idx++;
+    }
+  }
+
+  const char *suffix_str = suffix ? suffix : "";
+  int len;
+
+  if (num == (double)(long long)num && num < 1000000) {
+    len = snprintf(buf, size, "%lld%s%s", (long long)num,
+                   prefixes[prefix_idx], suffix_str);
+  } else if (num >= 100 || prefix_idx == 0) {
+    len = snprintf(buf, size, "%.0f%s%s", num, prefixes[prefix_idx],
+                   suffix_str);
+  } else if (num >= 10) {
+    len = snprintf(buf, size, "%.1f%s%s", num, prefixes[prefix_idx],
+                   suffix_str);
+  } else {
+    len = snprintf(buf, size, "%.2f%s%s", num, prefixes[prefix_idx],
+                   suffix_str);
+  }
+
+  return tqdm_fmt_clamp(len, size);
+}
+
+size_t tqdm_fmt_interval(char *buf, size_t size, double t) {
+  if (t < 0 || t > 86400 * 365)
+    return tqdm_fmt_clamp(snprintf(buf, size, "?"), size);
+
+  int total_seconds = (int)t;
+  int hours = total_seconds / 3600;
+  int minutes = (total_seconds % 3600) / 60;
+  int seconds = total_seconds % 60;
+
+  if (hours > 0)
+    return tqdm_fmt_clamp(
+        snprintf(buf, size, "%02d:%02d:%02d", hours, minutes, seconds), size);
+  return tqdm_fmt_clamp(snprintf(buf, size, "%02d:%02d", minutes, seconds),
+                        size);
+}
+
+size_t tqdm_fmt_num(char *buf, size_t size, double n) {
+  /* Human‐readable suffix formatting: k (thousand), m (million), b (billion),
+   * t (trillion). For numbers beyond 1e15 we fall back to scientific notation
+   */
+  double absn = fabs(n);
+  const char *suffix = "";
+  double scaled = n;
+  if (absn >= 1e12 && absn < 1e15) {
+    suffix = "t";
+    scaled = n / 1e12;
+  } else if (absn >= 1e9 && absn < 1e15) {
+    suffix = "b";
+    scaled = n / 1e9;
+  } else if (absn >= 1e6 && absn < 1e15) {
+    suffix = "m";
+    scaled = n / 1e6;
+  } else if (absn >= 1e3 && absn < 1e15) {
+    suffix = "k";
+    scaled = n / 1e3;
+  }
+
+  int len;
+  if (suffix[0] != '\0') {
+    if (fabs(scaled) >= 100) {
+      len = snprintf(buf, size, "%.0f%s", scaled, suffix);
+    } else if (fabs(scaled) >= 10) {
+      len = snprintf(buf, size, "%.1f%s", scaled, suffix);
+    } else {
+      len = snprintf(buf, size, "%.2f%s", scaled, suffix);
+    }
+  } else if (absn < 1000 && n == (double)(long long)n) {
+    len = snprintf(buf, size, "%lld", (long long)n);
+  } else if (absn < 1e15) {
+    len = snprintf(buf, size, "%.0f", n);
+  } else {
+    len = snprintf(buf, size, "%.3g", n);
+  }
+
+  return tqdm_fmt_clamp(len, size);
+}
+
+/* =============================
+ * Format compiler
+ * ============================= */
+typedef struct {
+  const char *name;
+  unsigned char field;
+  char type; /* 's' string, 'f' real, 'd' integer, 'b' the bar */
+} tqdm_field_info_t;
+
+#define TQDM_FIELD_INFO(name, id, type) {#name, TQDM_FIELD_##id, type},
+static const tqdm_field_info_t tqdm_fields[] = {
+    TQDM_FORMAT_FIELDS(TQDM_FIELD_INFO)};
+#undef TQDM_FIELD_INFO
+
+static const tqdm_field_info_t *tqdm_field_lookup(const char *name,
+                                                  size_t len) {
+  for (size_t i = 0; i < sizeof(tqdm_fields) / sizeof(tqdm_fields[0]); i++) {
+    if (strlen(tqdm_fields[i].name) == len &&
+        memcmp(tqdm_fields[i].name, name, len) == 0)
+      return &tqdm_fields[i];
+  }
+  return NULL;
+}
+
+static bool tqdm_parse_digits(const char **p, const char *end, int max_digits,
+                              int *value) {
+  int digits = 0;
+  *value = 0;
+  while (*p < end && **p >= '0' && **p <= '9') {
+    if (++digits > max_digits)
+      return false;
+    *value = *value * 10 + (**p - '0');
+    (*p)++;
+  }
+  return true;
+}
+
+/* Subset of Python's format spec mini-language: [align][sign][#][0]
+ * [width][.precision][type] for numbers, [align][width] for strings */
+static bool tqdm_parse_spec(tqdm_token_t *tok, char type, const char *p,
+                            const char *end) {
+  char align = 0;
+  if (p < end && (*p == '<' || *p == '>' || *p == '^'))
+    align = *p++;
+
+  if (type == 's') {
+    int width;
+    if (!tqdm_parse_digits(&p, end, 3, &width) || p != end)
+      return false;
+    tok->align = align;
+    tok->width = (unsigned short)width;
+    return true;
+  }
+  if (type != 'f' && type != 'd')
+    return false;
+
+  char *c = tok->conv;
+  *c++ = '%';
+  if (align == '<')
+    *c++ = '-';
+  else if (align == '^')
+    return false;
+  if (p < end && (*p == '+' || *p == ' '))
+    *c++ = *p++;
+  if (p < end && *p == '#')
+    *c++ = *p++;
+  if (p < end && *p == '0')
+    *c++ = *p++;
+
+  int width, precision = -1;
+  const char *digits = p;
+  if (!tqdm_parse_digits(&p, end, 3, &width))
+    return false;
+  memcpy(c, digits, (size_t)(p - digits));
+  c += p - digits;
+  if (p < end && *p == '.') {
+    digits = p++;
+    if (!tqdm_parse_digits(&p, end, 2, &precision) || p == digits + 1)
+      return false;
+    memcpy(c, digits, (size_t)(p - digits));
+    c += p - digits;
+  }
+
+  char conv = type == 'd' && precision < 0 ? 'd' : 'g';
+  if (p < end && strchr("deEfFgG", *p))
+    conv = *p++;
+  if (p != end)
+    return false;
+
+  /* Integers print as long long, everything else as double */
+  if (conv == 'd') {
+    *c++ = 'l';
+    *c++ = 'l';
+  }
+  *c++ = conv;
+  *c = '\0';
+  return true;
+}
+
+static bool tqdm_format_push(tqdm_format_t *fmt, tqdm_token_t **tok) {
+  if (fmt->ntokens >= TQDM_FORMAT_MAX_TOKENS)
+    return false;
+  *tok = &fmt->tokens[fmt->ntokens++];
+  memset(*tok, 0, sizeof(**tok));
+  return true;
+}
+
+static bool tqdm_format_literal(tqdm_format_t *fmt, const char *from,
+                                const char *to) {
+  tqdm_token_t *tok;
+  if (from == to)
+    return true;
+  if (!tqdm_format_push(fmt, &tok))
+    return false;
+  tok->field = TQDM_FIELD_LITERAL;
+  tok->off = (unsigned short)(from - fmt->text);
+  tok->len = (unsigned short)(to - from);
+  return true;
+}
+
+bool tqdm_format_compile(tqdm_format_t *fmt, const char *text) {
+  fmt->text = text;
+  fmt->ntokens = 0;
+  if (strlen(text) > 0xffff)
+    return false;
+
+  const char *lit = text;
+  const char *p = text;
+  while (*p) {
+    /* "{{" and "}}" are literal braces */
+    if ((p[0] == '{' && p[1] == '{') || (p[0] == '}' && p[1] == '}')) {
+      if (!tqdm_format_literal(fmt, lit, p + 1))
+        return false;
+      p += 2;
+      lit = p;
+      continue;
+    }
+    if (*p == '}')
+      return false;
+    if (*p != '{') {
+      p++;
+      continue;
+    }
+
+    if (!tqdm_format_literal(fmt, lit, p))
+      return false;
+
+    const char *name = p + 1;
+    const char *close = strchr(name, '}');
+    if (!close)
+      return false;
+    const char *colon = memchr(name, ':', (size_t)(close - name));
+    const char *name_end = colon ? colon : close;
+
+    const tqdm_field_info_t *info =
+        tqdm_field_lookup(name, (size_t)(name_end - name));
+    tqdm_token_t *tok;
+    if (!info || !tqdm_format_push(fmt, &tok))
+      return false;
+    tok->field = info->field;
+    if (colon && !tqdm_parse_spec(tok, info->type, colon + 1, close))
+      return false;
+
+    p = close + 1;
+    lit = p;
+  }
+  return tqdm_format_literal(fmt, lit, p);
+}
+
+/* =============================
+ * Renderer
+ * =============================
+ * Fields are written straight into the output buffer. The {bar} field is
+ * sized from whatever columns the rest of the line leaves, so it is filled
+ * in last and the tail after it is shifted right to make room.
+ */
+#define TQDM_X10(s) s s s s s s s s s s
+
+static const tqdm_glyphs_t tqdm_glyphs_unicode = {
+    TQDM_X10(TQDM_X10("█")), TQDM_X10(TQDM_X10(" ")), sizeof("█") - 1,
+    tqdm_unicode_blocks};
+
+static const tqdm_glyphs_t tqdm_glyphs_ascii = {
+    TQDM_X10(TQDM_X10("#")), TQDM_X10(TQDM_X10(" ")), 1, NULL};
+
+typedef struct {
+  char *buf;
+  size_t size; /* Including the terminator */
+  size_t len;
+} tqdm_out_t;
+
+static void tqdm_out_put(tqdm_out_t *out, const char *s, size_t len) {
+  size_t room = out->size - 1 - out->len;
+  if (len > room)
+    len = room;
+  memcpy(out->buf + out->len, s, len);
+  out->len += len;
+}
+
+static void tqdm_out_str(tqdm_out_t *out, const char *s) {
+  tqdm_out_put(out, s, strlen(s));
+}
+
+static void tqdm_out_fill(tqdm_out_t *out, size_t count) {
+  while (count > 0) {
+    size_t chunk = count < TQDM_BAR_MAX_WIDTH ? count : TQDM_BAR_MAX_WIDTH;
+    tqdm_out_put(out, tqdm_glyphs_ascii.blank, chunk);
+    count -= chunk;
+  }
+}
+
+/* Terminal columns taken by s: one per code point, escapes excluded */
+static size_t tqdm_visible_width(const char *s, size_t len) {
+  size_t width = 0;
+  for (size_t i = 0; i < len; i++) {
+    unsigned char c = (unsigned char)s[i];
+    if (c == 0x1b && i + 1 < len && s[i + 1] == '[') {
+      i += 2;
+      while (i < len && !(s[i] >= '@' && s[i] <= '~'))
+        i++;
+      continue;
+    }
+    if ((c & 0xc0) != 0x80)
+      width++;
+  }
+  return width;
+}
+
+static void tqdm_out_padded(tqdm_out_t *out, const tqdm_token_t *tok,
+                            const char *s, size_t len) {
+  size_t width = tqdm_visible_width(s, len);
+  size_t pad = tok->width > width ? tok->width - width : 0;
+  size_t left = tok->align == '>' ? pad : tok->align == '^' ? pad / 2 : 0;
+
+  tqdm_out_fill(out, left);
+  tqdm_out_put(out, s, len);
+  tqdm_out_fill(out, pad - left);
+}
+
+static void tqdm_out_number(tqdm_out_t *out, const tqdm_token_t *tok,
+                            double value, const char *fallback_conv) {
+  char tmp[64];
+  const char *conv = tok->conv[0] ? tok->conv : fallback_conv;
+  int len;
+
+  /* conv is one of the fallbacks or was built by tqdm_parse_spec */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+  if (strstr(conv, "lld"))
+    len = snprintf(tmp, sizeof(tmp), conv, (long long)value);
+  else
+    len = snprintf(tmp, sizeof(tmp), conv, value);
+#pragma GCC diagnostic pop
+
+  tqdm_out_put(out, tmp, tqdm_fmt_clamp(len, sizeof(tmp)));
+}
+
+/* Done fraction in [0, 1]. A weighted bar with no cost total falls back
+ * to its item count. */
+static double tqdm_meter_fraction(const tqdm_meter_t *m) {
+  double frac = 0.0;
+  if (m->total > 0)
+    frac = (double)m->n / m->total;
+  else if (m->weighted && m->items_total > 0)
+    frac = (double)m->items / m->items_total;
+  return frac > 1.0 ? 1.0 : frac;
+}
+
+static double tqdm_meter_percentage(const tqdm_meter_t *m) {
+  return 100.0 * tqdm_meter_fraction(m);
+}
+
+static const char *tqdm_style_unit(const tqdm_style_t *style) {
+  return style->params.unit ? style->params.unit : "it";
+}
+
+static int tqdm_style_divisor(const tqdm_style_t *style) {
+  return (int)style->params.unit_divisor;
+}
+
+/* n_fmt / total_fmt */
+static size_t tqdm_fmt_count(char *buf, size_t size, double value,
+                             const tqdm_style_t *style) {
+  if (style->params.unit_scale)
+    return tqdm_fmt_sizeof(buf, size, value, tqdm_style_unit(style),
+                           tqdm_style_divisor(style));
+  return tqdm_fmt_num(buf, size, value);
+}
+
+static size_t tqdm_fmt_rate(char *buf, size_t size, const tqdm_meter_t *m,
+                            const tqdm_style_t *style) {
+  const char *unit = tqdm_style_unit(style);
+  size_t len;
+
+  if (m->stalled_for > 0)
+    return tqdm_fmt_clamp(
+        snprintf(buf, size, "STALLED %.0fs", m->stalled_for), size);
+  if (m->rate <= 0) {
+    len = tqdm_fmt_clamp(
+        snprintf(buf, size, "?%s", style->params.unit_scale ? "" : unit),
+        size);
+  } else if (style->params.unit_scale) {
+    len = tqdm_fmt_sizeof(buf, size, m->rate, unit, tqdm_style_divisor(style));
+  } else {
+    len = tqdm_fmt_num(buf, size, m->rate);
+    len += tqdm_fmt_clamp(snprintf(buf + len, size - len, "%s", unit),
+                          size - len);
+  }
+  len += tqdm_fmt_clamp(snprintf(buf + len, size - len, "/s"), size - len);
+  return len;
+}
+
+static size_t tqdm_fmt_rate_inv(char *buf, size_t size, const tqdm_meter_t *m,
+                                const tqdm_style_t *style) {
+  size_t len;
+  if (m->rate <= 0)
+    len = tqdm_fmt_clamp(snprintf(buf, size, "?"), size);
+  else if (style->params.unit_scale)
+    len = tqdm_fmt_sizeof(buf, size, 1.0 / m->rate, NULL,
+                          tqdm_style_divisor(style));
+  else
+    len = tqdm_fmt_clamp(snprintf(buf, size, "%.2f", 1.0 / m->rate), size);
+  len += tqdm_fmt_clamp(
+      snprintf(buf + len, size - len, "s/%s", tqdm_style_unit(style)),
+      size - len);
+  return len;
+}
+
+static void tqdm_render_token(tqdm_out_t *out, const tqdm_token_t *tok,
+                              const tqdm_meter_t *m,
+                              const tqdm_style_t *style);
+
+/* One cell per recent rate sample, scaled to the largest, with the bar's
+ * partial-block glyphs; samples not yet taken are blank. A stall shows as
+ * an empty cell. */
+static size_t tqdm_fmt_sparkline(char *buf, size_t size, const tqdm_meter_t *m,
+                                 const tqdm_style_t *style) {
+  tqdm_out_t out = {buf, size, 0};
+  size_t levels = style->params.ascii ? strlen(tqdm_ascii_blocks) : 9;
+  double max = 0.0;
+  for (size_t i = 0; i < m->spark_len; i++) {
+    if (m->spark[i] > max)
+      max = m->spark[i];
+  }
+
+  tqdm_out_fill(&out, TQDM_RATE_HISTORY_SIZE - m->spark_len);
+  for (size_t i = 0; i < m->spark_len; i++) {
+    size_t level =
+        max > 0 ? (size_t)lround(m->spark[i] / max * (levels - 1)) : 0;
+    if (style->params.ascii)
+      tqdm_out_put(&out, tqdm_ascii_blocks + level, 1);
+    else
+      tqdm_out_str(&out, tqdm_unicode_blocks[level]);
+  }
+  return out.len;
+}
+
+/* "12:00–18:30": the ETA between the rate quantiles. "?" until there
+ * are enough rate samples; an open upper end is "12:00–?". */
+static size_t tqdm_fmt_eta_range(char *buf, size_t size, const tqdm_meter_t *m,
+                                 const tqdm_style_t *style) {
+  if (m->remaining_low < 0)
+    return 0;
+  tqdm_out_t out = {buf, size, 0};
+  char tmp[32];
+  tqdm_out_put(&out, tmp, tqdm_fmt_interval(tmp, sizeof(tmp),
+                                            m->remaining_low));
+  tqdm_out_str(&out, style->params.ascii ? "-" : "–");
+  if (m->remaining_high < 0)
+    tqdm_out_str(&out, "?");
+  else
+    tqdm_out_put(&out, tmp, tqdm_fmt_interval(tmp, sizeof(tmp),
+                                              m->remaining_high));
+  return out.len;
+}
+
+/* Item counts of a weighted bar; plain bars count items in n */
+static size_t tqdm_meter_items(const tqdm_meter_t *m) {
+  return m->weighted ? m->items : m->n;
+}
+
+static size_t tqdm_meter_items_total(const tqdm_meter_t *m) {
+  return m->weighted ? m->items_total : m->total;
+}
+
+/* The default layout's halves, as in Python's l_bar and r_bar */
+static void tqdm_render_l_bar(tqdm_out_t *out, const tqdm_meter_t *m) {
+  bool desc = m->desc && m->desc[0], phase = m->phase && m->phase[0];
+  if (desc)
+    tqdm_out_str(out, m->desc);
+  if (phase) {
+    tqdm_out_str(out, desc ? " [" : "[");
+    tqdm_out_str(out, m->phase);
+    tqdm_out_str(out, "]");
+  }
+  if (desc || phase)
+    tqdm_out_str(out, ": ");
+  char tmp[16];
+  int len = snprintf(tmp, sizeof(tmp), "%3.0f%%|", tqdm_meter_percentage(m));
+  tqdm_out_put(out, tmp, tqdm_fmt_clamp(len, sizeof(tmp)));
+}
+
+static void tqdm_render_r_bar(tqdm_out_t *out, const tqdm_meter_t *m,
+                              const tqdm_style_t *style) {
+  static const struct {
+    const char *before;
+    unsigned char field;
+  } parts[] = {
+      {"| ", TQDM_FIELD_N_FMT},     {"/", TQDM_FIELD_TOTAL_FMT},
+      {" [", TQDM_FIELD_ELAPSED},   {"<", TQDM_FIELD_REMAINING},
+      {", ", TQDM_FIELD_RATE_FMT},
+  };
+  tqdm_token_t tok;
+  memset(&tok, 0, sizeof(tok));
+
+  for (size_t i = 0; i < sizeof(parts) / sizeof(parts[0]); i++) {
+    tqdm_out_str(out, parts[i].before);
+    tok.field = parts[i].field;
+    tqdm_render_token(out, &tok, m, style);
+
+    /* Weighted bars show the item count next to the cost */
+    if (m->weighted && parts[i].field == TQDM_FIELD_TOTAL_FMT) {
+      char tmp[64];
+      size_t len = tqdm_fmt_num(tmp, sizeof(tmp), (double)m->items);
+      tqdm_out_str(out, " (");
+      tqdm_out_put(out, tmp, len);
+      tqdm_out_str(out, "/");
+      if (m->items_total > 0) {
+        len = tqdm_fmt_num(tmp, sizeof(tmp), (double)m->items_total);
+        tqdm_out_put(out, tmp, len);
+      } else {
+        tqdm_out_str(out, "?");
+      }
+      tqdm_out_str(out, ")");
+    }
+  }
+  tqdm_out_str(out, "]");
+  if (m->postfix && m->postfix[0]) {
+    tqdm_out_str(out, " ");
+    tqdm_out_str(out, m->postfix);
+  }
+}
+
+static void tqdm_render_token(tqdm_out_t *out, const tqdm_token_t *tok,
+                              const tqdm_meter_t *m,
+                              const tqdm_style_t *style) {
+  char tmp[96];
+  size_t len = 0;
+  const char *s = tmp;
+
+  switch ((tqdm_field_t)tok->field) {
+  case TQDM_FIELD_LITERAL:
+    tqdm_out_put(out, style->format.text + tok->off, tok->len);
+    return;
+  case TQDM_FIELD_BAR:
+    return; /* Filled in by tqdm_render_meter */
+  case TQDM_FIELD_L_BAR:
+  case TQDM_FIELD_R_BAR: {
+    char part_buf[512];
+    tqdm_out_t part = {part_buf, sizeof(part_buf), 0};
+    tqdm_out_t *dst = tok->width ? &part : out;
+    if (tok->field == TQDM_FIELD_L_BAR)
+      tqdm_render_l_bar(dst, m);
+    else
+      tqdm_render_r_bar(dst, m, style);
+    if (tok->width)
+      tqdm_out_padded(out, tok, part.buf, part.len);
+    return;
+  }
+  case TQDM_FIELD_PERCENTAGE:
+    tqdm_out_number(out, tok, tqdm_meter_percentage(m), "%3.0f");
+    return;
+  case TQDM_FIELD_N:
+    tqdm_out_number(out, tok, (double)m->n, "%lld");
+    return;
+  case TQDM_FIELD_TOTAL:
+    tqdm_out_number(out, tok, (double)m->total, "%lld");
+    return;
+  case TQDM_FIELD_TOTAL_EST:
+    if (m->total_estimate == 0)
+      break;
+    tqdm_out_number(out, tok, (double)m->total_estimate, "%lld");
+    return;
+  case TQDM_FIELD_ITEMS:
+    tqdm_out_number(out, tok, (double)tqdm_meter_items(m), "%lld");
+    return;
+  case TQDM_FIELD_ITEMS_TOTAL:
+    tqdm_out_number(out, tok, (double)tqdm_meter_items_total(m), "%lld");
+    return;
+  case TQDM_FIELD_ELAPSED_S:
+    tqdm_out_number(out, tok, m->elapsed, "%.1f");
+    return;
+  case TQDM_FIELD_REMAINING_S:
+    if (m->remaining < 0)
+      break;
+    tqdm_out_number(out, tok, m->remaining, "%.1f");
+    return;
+  case TQDM_FIELD_RATE:
+  case TQDM_FIELD_RATE_NOINV:
+    if (m->rate <= 0)
+      break;
+    tqdm_out_number(out, tok, m->rate, "%.2f");
+    return;
+  case TQDM_FIELD_RATE_INV:
+    if (m->rate <= 0)
+      break;
+    tqdm_out_number(out, tok, 1.0 / m->rate, "%.2f");
+    return;
+  case TQDM_FIELD_DESC:
+    s = m->desc ? m->desc : "";
+    len = strlen(s);
+    break;
+  case TQDM_FIELD_PHASE:
+    s = m->phase ? m->phase : "";
+    len = strlen(s);
+    break;
+  case TQDM_FIELD_N_FMT:
+    len = tqdm_fmt_count(tmp, sizeof(tmp), (double)m->n, style);
+    break;
+  case TQDM_FIELD_TOTAL_FMT:
+    if (m->total == 0)
+      break;
+    len = tqdm_fmt_count(tmp, sizeof(tmp), (double)m->total, style);
+    break;
+  case TQDM_FIELD_ELAPSED:
+    len = tqdm_fmt_interval(tmp, sizeof(tmp), m->elapsed);
+    break;
+  case TQDM_FIELD_REMAINING:
+    len = tqdm_fmt_interval(tmp, sizeof(tmp), m->remaining);
+    break;
+  case TQDM_FIELD_RATE_FMT:
+  case TQDM_FIELD_RATE_NOINV_FMT:
+    len = tqdm_fmt_rate(tmp, sizeof(tmp), m, style);
+    break;
+  case TQDM_FIELD_RATE_INV_FMT:
+    len = tqdm_fmt_rate_inv(tmp, sizeof(tmp), m, style);
+    break;
+  case TQDM_FIELD_SPARKLINE:
+    len = tqdm_fmt_sparkline(tmp, sizeof(tmp), m, style);
+    break;
+  case TQDM_FIELD_ETA_RANGE:
+    len = tqdm_fmt_eta_range(tmp, sizeof(tmp), m, style);
+    break;
+  case TQDM_FIELD_UNIT:
+    s = tqdm_style_unit(style);
+    len = strlen(s);
+    break;
+  case TQDM_FIELD_POSTFIX:
+    s = m->postfix ? m->postfix : "";
+    len = strlen(s);
+    break;
+  }
+
+  /* Unknown values print as "?" */
+  if (s == tmp && len == 0) {
+    tmp[0] = '?';
+    len = 1;
+  }
+  tqdm_out_padded(out, tok, s, len);
+}
+
+static size_t tqdm_render_bar(char *buf, size_t size, const tqdm_meter_t *m,
+                              const tqdm_style_t *style, int width) {
+  const tqdm_glyphs_t *g = style->glyphs;
+  tqdm_out_t out = {buf, size, 0};
+  double frac = tqdm_meter_fraction(m);
+
+  int full, partial = 0;
+  if (g->partials) {
+    int eighths = (int)(frac * width * 8);
+    full = eighths / 8;
+    partial = eighths % 8;
+  } else {
+    full = (int)(frac * width);
+  }
+
+  tqdm_out_str(&out, style->colour_on);
+  tqdm_out_put(&out, g->full, (size_t)full * g->cell_bytes);
+  if (partial > 0)
+    tqdm_out_str(&out, g->partials[partial]);
+  tqdm_out_put(&out, g->blank, (size_t)(width - full - (partial > 0)));
+  if (style->colour_on[0])
+    tqdm_out_str(&out, "\033[0m");
+  return out.len;
+}
+
+size_t tqdm_render_meter(char *buf, size_t size, const tqdm_meter_t *meter,
+                         const tqdm_style_t *style) {
+  if (size == 0)
+    return 0;
+
+  tqdm_out_t out = {buf, size, 0};
+  const tqdm_format_t *fmt = &style->format;
+  size_t bar_at = (size_t)-1;
+
+  for (size_t i = 0; i < fmt->ntokens; i++) {
+    if (fmt->tokens[i].field == TQDM_FIELD_BAR && bar_at == (size_t)-1)
+      bar_at = out.len;
+    tqdm_render_token(&out, &fmt->tokens[i], meter, style);
+  }
+
+  if (bar_at != (size_t)-1) {
+    int width = 10;
+    if (meter->ncols > 0)
+      width = meter->ncols - (int)tqdm_visible_width(buf, out.len);
+    if (width < 1)
+      width = 1;
+    if (width > TQDM_BAR_MAX_WIDTH)
+      width = TQDM_BAR_MAX_WIDTH;
+
+    char bar[TQDM_BAR_MAX_WIDTH * 4 + 2 * TQDM_COLOUR_ESC_SIZE];
+    size_t bar_len = tqdm_render_bar(bar, sizeof(bar), meter, style, width);
+
+    /* Shift the tail right; whatever no longer fits is dropped */
+    size_t room = size - 1 - bar_at;
+    if (bar_len > room)
+      bar_len = room;
+    size_t tail = out.len - bar_at;
+    if (tail > room - bar_len)
+      tail = room - bar_len;
+    memmove(buf + bar_at + bar_len, buf + bar_at, tail);
+    memcpy(buf + bar_at, bar, bar_len);
+    out.len = bar_at + bar_len + tail;
+  }
+
+  buf[out.len] = '\0';
+  return out.len;
+}
+
+/* =============================
+ * Style setup
+ * ============================= */
+static const char *tqdm_default_format = "{l_bar}{bar}{r_bar}";
+
+static void tqdm_colour_escape(char *esc, size_t size, const char *colour) {
+  static const char *names[] = {"black", "red",     "green", "yellow",
+                                "blue",  "magenta", "cyan",  "white"};
+  unsigned r, g, b;
+
+  esc[0] = '\0';
+  if (!colour || !colour[0])
+    return;
+
+  if (colour[0] == '#' && strlen(colour) == 7 &&
+      sscanf(colour + 1, "%2x%2x%2x", &r, &g, &b) == 3) {
+    snprintf(esc, size, "\033[38;2;%u;%u;%um", r, g, b);
+    return;
+  }
+  for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+    if (strcasecmp(colour, names[i]) == 0) {
+      snprintf(esc, size, "\033[%zum", 30 + i);
+      return;
+    }
+  }
+  /* Unknown colours are ignored, as in Python tqdm */
+}
+
+bool tqdm_style_setup(tqdm_style_t *style, const tqdm_params_t *params) {
+  bool ok = true;
+
+  style->params = *params;
+  style->glyphs = params->ascii ? &tqdm_glyphs_ascii : &tqdm_glyphs_unicode;
+  tqdm_colour_escape(style->colour_on, sizeof(style->colour_on),
+                     params->colour);
+
+  if (params->bar_format && params->bar_format[0] &&
+      !tqdm_format_compile(&style->format, params->bar_format))
+    ok = false;
+  if (!ok || !params->bar_format || !params->bar_format[0])
+    tqdm_format_compile(&style->format, tqdm_default_format);
+  return ok;
+}
@@ -0,0 +1,149 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tqdm_internal.h"
+
+/* =============================
+ * Shared styles
+ * =============================
+ * A style is built once from params and never changes afterwards, so any
+ * number of bars (on any thread) can render from it without locking. The
+ * strings it needs live in the same allocation as the style itself.
+ */
+static char *tqdm_style_copy_str(char **dst, const char *src) {
+  size_t len = strlen(src) + 1;
+  memcpy(*dst, src, len);
+  *dst += len;
+  return *dst - len;
+}
+
+/* Strict styles reject a bad bar_format; others fall back to the default
+ * layout */
+static tqdm_style_t *tqdm_style_build(const tqdm_params_t *params,
+                                      bool strict) {
+  tqdm_params_t tpl = params ? *params : tqdm_static_default_params();
+  size_t strings = 0;
+
+  if (tpl.unit)
+    strings += strlen(tpl.unit) + 1;
+  if (tpl.bar_format)
+    strings += strlen(tpl.bar_format) + 1;
+  if (tpl.colour)
+    strings += strlen(tpl.colour) + 1;
+  if (tpl.history_file)
+    strings += strlen(tpl.history_file) + 1;
+
+  tqdm_style_t *style = malloc(sizeof(*style) + strings);
+  if (!style)
+    return NULL;
+
+  char *dst = style->strings;
+  if (tpl.unit)
+    tpl.unit = tqdm_style_copy_str(&dst, tpl.unit);
+  if (tpl.bar_format)
+    tpl.bar_format = tqdm_style_copy_str(&dst, tpl.bar_format);
+  if (tpl.colour)
+    tpl.colour = tqdm_style_copy_str(&dst, tpl.colour);
+  if (tpl.history_file)
+    tpl.history_file = tqdm_style_copy_str(&dst, tpl.history_file);
+
+  /* Per-bar strings are not part of the template */
+  tpl.desc = NULL;
+  tpl.postfix = NULL;
+
+  if (!tqdm_style_setup(style, &tpl) && strict) {
+    free(style);
+    errno = EINVAL;
+    return NULL;
+  }
+
+  style->refs = 1;
+  return style;
+}
+
+tqdm_style_t *tqdm_style_create(const tqdm_params_t *params) {
+  return tqdm_style_build(params, true);
+}
+
+tqdm_style_t *tqdm_style_retain(tqdm_style_t *style) {
+  if (style)
+    __atomic_add_fetch(&style->refs, 1, __ATOMIC_RELAXED);
+  return style;
+}
+
+void tqdm_style_release(tqdm_style_t *style) {
+  if (style && __atomic_sub_fetch(&style->refs, 1, __ATOMIC_ACQ_REL) == 0)
+    free(style);
+}
+
+/* Bars created from params share the style of any recent bar that looked
+ * the same. The cache holds a reference to each entry for the life of the
+ * process; the oldest is dropped when a new look needs its slot. */
+#define TQDM_STYLE_CACHE_SIZE 8
+
+static pthread_mutex_t tqdm_style_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static tqdm_style_t *tqdm_style_cache[TQDM_STYLE_CACHE_SIZE];
+static size_t tqdm_style_cache_next;
+
+static bool tqdm_style_str_eq(const char *a, const char *b) {
+  return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+/* Only what the renderer reads from style->params */
+static bool tqdm_style_matches(const tqdm_style_t *style,
+                               const tqdm_params_t *params) {
+  const tqdm_params_t *p = &style->params;
+  return p->ascii == params->ascii && p->unit_scale == params->unit_scale &&
+         p->unit_divisor == params->unit_divisor &&
+         tqdm_style_str_eq(p->unit, params->unit) &&
+         tqdm_style_str_eq(p->bar_format, params->bar_format) &&
+         tqdm_style_str_eq(p->colour, params->colour);
+}
+
+tqdm_style_t *tqdm_style_for_params(const tqdm_params_t *params) {
+  tqdm_style_t *style = NULL;
+
+  pthread_mutex_lock(&tqdm_style_cache_lock);
+  for (size_t i = 0; i < TQDM_STYLE_CACHE_SIZE && !style; i++) {
+    if (tqdm_style_cache[i] && tqdm_style_matches(tqdm_style_cache[i], params))
+      style = tqdm_style_retain(tqdm_style_cache[i]);
+  }
+  if (!style && (style = tqdm_style_build(params, false)) != NULL) {
+    size_t slot = tqdm_style_cache_next++ % TQDM_STYLE_CACHE_SIZE;
+    tqdm_style_release(tqdm_style_cache[slot]);
+    tqdm_style_cache[slot] = tqdm_style_retain(style);
+  }
+  pthread_mutex_unlock(&tqdm_style_cache_lock);
+  return style;
+}
+
+bool tqdm_style_has_field(const tqdm_style_t *style, tqdm_field_t field) {
+  for (size_t i = 0; style && i < style->format.ntokens; i++) {
+    if (style->format.tokens[i].field == field)
+      return true;
+  }
+  return false;
+}
+
+size_t tqdm_style_render(const tqdm_style_t *style, const tqdm_frame_t *frame,
+                         char *buf, size_t size) {
+  if (!style || !frame || !buf || size == 0)
+    return 0;
+
+  tqdm_meter_t meter = {
+      .n = frame->n,
+      .total = frame->total,
+      .total_estimate = frame->total,
+      .elapsed = frame->elapsed,
+      .rate = frame->rate,
+      .remaining = frame->remaining,
+      .desc = frame->desc,
+      .postfix = frame->postfix,
+      .ncols = frame->ncols > 0 ? frame->ncols : get_terminal_width(),
+      .remaining_low = -1.0,
+      .remaining_high = -1.0,
+  };
+  return tqdm_render_meter(buf, size, &meter, style);
+}
@@ -1,16 +1,22 @@
+#define _GNU_SOURCE /* asprintf */
 #include <ctype.h>
+#include <errno.h>
 #include <math.h>
+#include <stddef.h>
 #include <pthread.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <time.h>
 #include <unistd.h>
 
+#define TQDM_BUILDING_LIBRARY /* never the TQDM_DISABLE_ALL stubs */
 #include "tqdm/tqdm.h"
+#include "tqdm_internal.h"
 
 /* =============================
  * Globals / constants
@@ -25,16 +31,45 @@ const char *tqdm_ascii_blocks = " 123456789#";
 
 #define TQDM_ENV_PREFIX "TQDM_"
 
+/* =============================
+ * Layout checks
+ * ============================= */
+#define TQDM_STATIC_ASSERT(cond, name)                                       \
+  typedef char tqdm_static_assert_##name[(cond) ? 1 : -1]
+
+#define TQDM_LINE_OF(field) (offsetof(tqdm_t, field) / TQDM_CACHELINE)
+
+/* The update path's counters share one line */
+TQDM_STATIC_ASSERT(offsetof(tqdm_t, n) % TQDM_CACHELINE == 0, hot_aligned);
+TQDM_STATIC_ASSERT(TQDM_LINE_OF(n) == TQDM_LINE_OF(cost) &&
+                       TQDM_LINE_OF(n) == TQDM_LINE_OF(count) &&
+                       TQDM_LINE_OF(n) == TQDM_LINE_OF(current),
+                   hot_one_line);
+/* ...which nothing read by the renderer or config readers lives on */
+TQDM_STATIC_ASSERT(offsetof(tqdm_t, last_print_time) % TQDM_CACHELINE == 0,
+                   render_aligned);
+TQDM_STATIC_ASSERT(offsetof(tqdm_t, last_print_time) >=
+                       offsetof(tqdm_t, lock) + sizeof(pthread_mutex_t),
+                   render_after_hot);
+TQDM_STATIC_ASSERT(offsetof(tqdm_t, params) % TQDM_CACHELINE == 0,
+                   config_aligned);
+TQDM_STATIC_ASSERT(offsetof(tqdm_t, params) >=
+                       offsetof(tqdm_t, rate_history_idx) + sizeof(size_t),
+                   config_after_render);
+TQDM_STATIC_ASSERT(offsetof(tqdm_t, rate_history) % TQDM_CACHELINE == 0,
+                   cold_aligned);
+TQDM_STATIC_ASSERT(sizeof(tqdm_t) % TQDM_CACHELINE == 0, size_padded);
+
 /* =============================
  * Tiny utility helpers
  * ============================= */
-static double current_time_seconds(void) {
+double current_time_seconds(void) {
   struct timeval tv;
   gettimeofday(&tv, NULL);
   return tv.tv_sec + tv.tv_usec / 1000000.0;
 }
 
-static int get_terminal_width(void) {
+int get_terminal_width(void) {
   struct winsize w;
   return (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) == 0) ? w.ws_col : 80;
 }
@@ -44,11 +79,281 @@ static int get_terminal_height(void) {
   return (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) == 0) ? w.ws_row : 24;
 }
 
+/* =============================
+ * Output checks
+ * =============================
+ * Bars writing where nobody can see are muted: they keep counting but
+ * never format or write a frame.
+ */
+static dev_t tqdm_devnull_rdev;
+static bool tqdm_devnull_known;
+static pthread_once_t tqdm_devnull_once = PTHREAD_ONCE_INIT;
+
+static void tqdm_devnull_init(void) {
+  struct stat st;
+  if (stat("/dev/null", &st) == 0 && S_ISCHR(st.st_mode)) {
+    tqdm_devnull_rdev = st.st_rdev;
+    tqdm_devnull_known = true;
+  }
+}
+
+bool tqdm_output_discarded(FILE *file) {
+  struct stat st;
+  int fd = file ? fileno(file) : -1;
+
+  /* No fd (e.g. fmemopen): assume someone reads it */
+  if (fd < 0)
+    return false;
+  if (fstat(fd, &st) != 0)
+    return errno == EBADF;
+
+  pthread_once(&tqdm_devnull_once, tqdm_devnull_init);
+  return tqdm_devnull_known && S_ISCHR(st.st_mode) &&
+         st.st_rdev == tqdm_devnull_rdev;
+}
+
+/* Flush a frame; false once the reader is gone for good. EPIPE needs
+ * SIGPIPE to be ignored, otherwise the process never gets here. */
+bool tqdm_output_flush(FILE *file) {
+  if (fflush(file) != EOF && !ferror(file))
+    return true;
+  clearerr(file);
+  return errno != EPIPE && errno != EBADF;
+}
+
 /* Print progress helper (forward decl) */
 static void tqdm_print_progress(tqdm_t *tqdm);
+static void tqdm_sample_muted(tqdm_t *tqdm);
+static bool tqdm_assign_str(tqdm_t *tqdm, int slot, char **field,
+                            const char *src);
 
-/* Default parameters */
-tqdm_params_t tqdm_default_params(void) {
+/* =============================
+ * Environment configuration
+ * =============================
+ * TQDM_* variables are parsed once per process into an immutable snapshot
+ * and applied from there, so creating a bar never scans environ.
+ * tqdm_reload_env() publishes a fresh snapshot and frees the retired ones
+ * once no reader is inside tqdm_env_apply. Params may keep pointing at
+ * snapshot strings, so those are interned for the life of the process:
+ * reloading the same environment allocates nothing new.
+ */
+enum {
+  TQDM_ENV_MININTERVAL = 1 << 0,
+  TQDM_ENV_MINITERS = 1 << 1,
+  TQDM_ENV_ASCII = 1 << 2,
+  TQDM_ENV_DISABLE = 1 << 3,
+  TQDM_ENV_UNIT = 1 << 4,
+  TQDM_ENV_UNIT_SCALE = 1 << 5,
+  TQDM_ENV_DYNAMIC_NCOLS = 1 << 6,
+  TQDM_ENV_SMOOTHING = 1 << 7,
+  TQDM_ENV_NCOLS = 1 << 8,
+  TQDM_ENV_COLOUR = 1 << 9,
+  TQDM_ENV_DELAY = 1 << 10,
+  TQDM_ENV_ESTIMATOR = 1 << 11,
+  TQDM_ENV_HISTORY_FILE = 1 << 12,
+};
+
+typedef struct tqdm_env_config_s {
+  unsigned set;         /* TQDM_ENV_* bits present in the environment */
+  tqdm_params_t values; /* Parsed values for those bits */
+  struct tqdm_env_config_s *retired; /* Previous snapshot */
+} tqdm_env_config_t;
+
+typedef struct tqdm_env_str_s {
+  struct tqdm_env_str_s *next;
+  char text[];
+} tqdm_env_str_t;
+
+static tqdm_env_config_t tqdm_env_initial;
+static tqdm_env_config_t *tqdm_env_current;
+static unsigned tqdm_env_readers; /* Threads holding a snapshot */
+static tqdm_env_str_t *tqdm_env_strings; /* Interned values, never freed */
+static pthread_once_t tqdm_env_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t tqdm_env_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Called from the once-init or under tqdm_env_lock */
+static char *tqdm_env_intern(const char *value) {
+  tqdm_env_str_t *str;
+  for (str = tqdm_env_strings; str; str = str->next) {
+    if (strcmp(str->text, value) == 0)
+      return str->text;
+  }
+  size_t len = strlen(value) + 1;
+  if (!(str = malloc(sizeof(*str) + len)))
+    return NULL;
+  memcpy(str->text, value, len);
+  str->next = tqdm_env_strings;
+  tqdm_env_strings = str;
+  return str->text;
+}
+
+static bool tqdm_env_bool(const char *val) {
+  return strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0;
+}
+
+static void tqdm_env_parse(tqdm_env_config_t *cfg) {
+  tqdm_params_t *v = &cfg->values;
+  char *env_val;
+
+  if ((env_val = getenv("TQDM_MININTERVAL")) != NULL) {
+    v->mininterval = atof(env_val);
+    cfg->set |= TQDM_ENV_MININTERVAL;
+  }
+  if ((env_val = getenv("TQDM_MINITERS")) != NULL) {
+    v->miniters = atoi(env_val);
+    cfg->set |= TQDM_ENV_MINITERS;
+  }
+  if ((env_val = getenv("TQDM_ASCII")) != NULL) {
+    v->ascii = tqdm_env_bool(env_val);
+    cfg->set |= TQDM_ENV_ASCII;
+  }
+  if ((env_val = getenv("TQDM_DISABLE")) != NULL) {
+    v->disable = tqdm_env_bool(env_val);
+    cfg->set |= TQDM_ENV_DISABLE;
+  }
+  if ((env_val = getenv("TQDM_UNIT")) != NULL &&
+      (v->unit = tqdm_env_intern(env_val)) != NULL) {
+    cfg->set |= TQDM_ENV_UNIT;
+  }
+  if ((env_val = getenv("TQDM_UNIT_SCALE")) != NULL) {
+    v->unit_scale = tqdm_env_bool(env_val);
+    cfg->set |= TQDM_ENV_UNIT_SCALE;
+  }
+  if ((env_val = getenv("TQDM_DYNAMIC_NCOLS")) != NULL) {
+    v->dynamic_ncols = tqdm_env_bool(env_val);
+    cfg->set |= TQDM_ENV_DYNAMIC_NCOLS;
+  }
+  if ((env_val = getenv("TQDM_SMOOTHING")) != NULL) {
+    v->smoothing =
+        strcmp(env_val, "auto") == 0 ? TQDM_SMOOTHING_AUTO : atof(env_val);
+    cfg->set |= TQDM_ENV_SMOOTHING;
+  }
+  if ((env_val = getenv("TQDM_NCOLS")) != NULL) {
+    v->ncols = atoi(env_val);
+    cfg->set |= TQDM_ENV_NCOLS;
+  }
+  if ((env_val = getenv("TQDM_COLOUR")) != NULL &&
+      (v->colour = tqdm_env_intern(env_val)) != NULL) {
+    cfg->set |= TQDM_ENV_COLOUR;
+  }
+  if ((env_val = getenv("TQDM_DELAY")) != NULL) {
+    v->delay = atof(env_val);
+    cfg->set |= TQDM_ENV_DELAY;
+  }
+  if ((env_val = getenv("TQDM_ESTIMATOR")) != NULL &&
+      (v->estimator = tqdm_estimator_find(env_val)) != NULL) {
+    cfg->set |= TQDM_ENV_ESTIMATOR;
+  }
+  if ((env_val = getenv("TQDM_HISTORY_FILE")) != NULL && env_val[0] &&
+      (v->history_file = tqdm_env_intern(env_val)) != NULL) {
+    cfg->set |= TQDM_ENV_HISTORY_FILE;
+  }
+}
+
+static void tqdm_env_init(void) {
+  tqdm_env_parse(&tqdm_env_initial);
+  __atomic_store_n(&tqdm_env_current, &tqdm_env_initial, __ATOMIC_RELEASE);
+}
+
+/* The current snapshot, valid until tqdm_env_release. A reload that sees
+ * no readers after publishing knows nobody can hold the old ones. */
+static const tqdm_env_config_t *tqdm_env_acquire(void) {
+  pthread_once(&tqdm_env_once, tqdm_env_init);
+  __atomic_add_fetch(&tqdm_env_readers, 1, __ATOMIC_SEQ_CST);
+  return __atomic_load_n(&tqdm_env_current, __ATOMIC_SEQ_CST);
+}
+
+static void tqdm_env_release(void) {
+  __atomic_sub_fetch(&tqdm_env_readers, 1, __ATOMIC_SEQ_CST);
+}
+
+void tqdm_reload_env(void) {
+  tqdm_env_config_t *cfg = calloc(1, sizeof(*cfg));
+  if (!cfg)
+    return;
+
+  pthread_once(&tqdm_env_once, tqdm_env_init);
+  pthread_mutex_lock(&tqdm_env_lock);
+  tqdm_env_parse(cfg);
+  cfg->retired = tqdm_env_current;
+  __atomic_store_n(&tqdm_env_current, cfg, __ATOMIC_SEQ_CST);
+
+  /* Readers still inside may hold a retired snapshot: the next reload
+   * frees it instead */
+  if (__atomic_load_n(&tqdm_env_readers, __ATOMIC_SEQ_CST) == 0) {
+    tqdm_env_config_t *old = cfg->retired;
+    cfg->retired = NULL;
+    while (old) {
+      tqdm_env_config_t *next = old->retired;
+      if (old != &tqdm_env_initial)
+        free(old);
+      old = next;
+    }
+  }
+  pthread_mutex_unlock(&tqdm_env_lock);
+}
+
+/* Apply a snapshot. Strings are taken by reference to the interned copies,
+ * which outlive the snapshot. */
+static void tqdm_env_apply(tqdm_params_t *params,
+                           const tqdm_env_config_t *cfg) {
+  const tqdm_params_t *v = &cfg->values;
+
+  if (cfg->set & TQDM_ENV_MININTERVAL)
+    params->mininterval = v->mininterval;
+  if (cfg->set & TQDM_ENV_MINITERS)
+    params->miniters = v->miniters;
+  if (cfg->set & TQDM_ENV_ASCII)
+    params->ascii = v->ascii;
+  if (cfg->set & TQDM_ENV_DISABLE)
+    params->disable = v->disable;
+  if (cfg->set & TQDM_ENV_UNIT)
+    params->unit = v->unit;
+  if (cfg->set & TQDM_ENV_UNIT_SCALE)
+    params->unit_scale = v->unit_scale;
+  if (cfg->set & TQDM_ENV_DYNAMIC_NCOLS)
+    params->dynamic_ncols = v->dynamic_ncols;
+  if (cfg->set & TQDM_ENV_SMOOTHING)
+    params->smoothing = v->smoothing;
+  if (cfg->set & TQDM_ENV_NCOLS)
+    params->ncols = v->ncols;
+  if (cfg->set & TQDM_ENV_COLOUR)
+    params->colour = v->colour;
+  if (cfg->set & TQDM_ENV_DELAY)
+    params->delay = v->delay;
+  if (cfg->set & TQDM_ENV_ESTIMATOR)
+    params->estimator = v->estimator;
+  if (cfg->set & TQDM_ENV_HISTORY_FILE)
+    params->history_file = v->history_file;
+}
+
+void tqdm_load_env_vars(tqdm_params_t *params) {
+  char *unit = params->unit;
+  char *colour = params->colour;
+  char *history_file = params->history_file;
+
+  tqdm_env_apply(params, tqdm_env_acquire());
+  tqdm_env_release();
+
+  /* The caller owns params' strings: copy the ones that came from env */
+  if (params->unit != unit) {
+    free(unit);
+    params->unit = strdup(params->unit);
+  }
+  if (params->colour != colour) {
+    free(colour);
+    params->colour = strdup(params->colour);
+  }
+  if (params->history_file != history_file) {
+    free(history_file);
+    params->history_file = strdup(params->history_file);
+  }
+}
+
+/* Default parameters, with the environment applied on top. Strings point
+ * at literals or interned env values: only for bars, which copy their
+ * strings, never for params handed back to the caller. */
+tqdm_params_t tqdm_static_default_params(void) {
   tqdm_params_t params;
   memset(&params, 0, sizeof(params));
 
@@ -61,7 +366,7 @@ tqdm_params_t tqdm_default_params(void) {
   params.miniters = 0;
   params.ascii = false;
   params.disable = false;
-  params.unit = strdup("it");
+  params.unit = (char *)"it";
   params.unit_scale = false;
   params.dynamic_ncols = false;
   params.smoothing = 0.3f;
@@ -72,10 +377,26 @@ tqdm_params_t tqdm_default_params(void) {
   params.unit_divisor = 1000.0f;
   params.colour = NULL;
   params.delay = 0.0f;
+  params.estimator = NULL;
+  params.cost_total = 0;
+  params.history_file = NULL;
+
+  tqdm_env_apply(&params, tqdm_env_acquire());
+  tqdm_env_release();
 
   return params;
 }
 
+tqdm_params_t tqdm_default_params(void) {
+  tqdm_params_t params = tqdm_static_default_params();
+  params.unit = strdup(params.unit);
+  if (params.colour)
+    params.colour = strdup(params.colour);
+  if (params.history_file)
+    params.history_file = strdup(params.history_file);
+  return params;
+}
+
 /* Cleanup */
 void tqdm_cleanup_params(tqdm_params_t *params) {
   if (!params)
@@ -86,57 +407,11 @@ void tqdm_cleanup_params(tqdm_params_t *params) {
   free(params->bar_format);
   free(params->colour);
   free(params->postfix);
+  free(params->history_file);
 
   memset(params, 0, sizeof(*params));
 }
 
-/* Environment variable loading */
-void tqdm_load_env_vars(tqdm_params_t *params) {
-  char *env_val;
-
-  if ((env_val = getenv("TQDM_MININTERVAL")) != NULL) {
-    params->mininterval = atof(env_val);
-  }
-  if ((env_val = getenv("TQDM_MINITERS")) != NULL) {
-    params->miniters = atoi(env_val);
-  }
-  if ((env_val = getenv("TQDM_ASCII")) != NULL) {
-    params->ascii =
-        (strcasecmp(env_val, "true") == 0 || strcmp(env_val, "1") == 0);
-  }
-  if ((env_val = getenv("TQDM_DISABLE")) != NULL) {
-    params->disable =
-        (strcasecmp(env_val, "true") == 0 || strcmp(env_val, "1") == 0);
-  }
-  if ((env_val = getenv("TQDM_UNIT")) != NULL) {
-    if (params->unit)
-      free(params->unit);
-    params->unit = strdup(env_val);
-  }
-  if ((env_val = getenv("TQDM_UNIT_SCALE")) != NULL) {
-    params->unit_scale =
-        (strcasecmp(env_val, "true") == 0 || strcmp(env_val, "1") == 0);
-  }
-  if ((env_val = getenv("TQDM_DYNAMIC_NCOLS")) != NULL) {
-    params->dynamic_ncols =
-        (strcasecmp(env_val, "true") == 0 || strcmp(env_val, "1") == 0);
-  }
-  if ((env_val = getenv("TQDM_SMOOTHING")) != NULL) {
-    params->smoothing = atof(env_val);
-  }
-  if ((env_val = getenv("TQDM_NCOLS")) != NULL) {
-    params->ncols = atoi(env_val);
-  }
-  if ((env_val = getenv("TQDM_COLOUR")) != NULL) {
-    if (params->colour)
-      free(params->colour);
-    params->colour = strdup(env_val);
-  }
-  if ((env_val = getenv("TQDM_DELAY")) != NULL) {
-    params->delay = atof(env_val);
-  }
-}
-
 /* =============================
  * Thread-safety helpers
  * ============================= */
@@ -149,18 +424,6 @@ pthread_mutex_t *tqdm_get_lock(void) {
   return tqdm_global_lock;
 }
 
-/* =============================
- * Monitor stubs (compatibility only)
- * ============================= */
-void tqdm_start_monitor(tqdm_t *tqdm) { (void)tqdm; }
-
-void tqdm_stop_monitor(tqdm_t *tqdm) { (void)tqdm; }
-
-void *tqdm_monitor_thread(void *arg) {
-  (void)arg;
-  return NULL;
-}
-
 /* Format dictionary */
 tqdm_format_dict_t *tqdm_format_dict(tqdm_t *tqdm) {
   static tqdm_format_dict_t simple_dict;
@@ -169,13 +432,14 @@ tqdm_format_dict_t *tqdm_format_dict(tqdm_t *tqdm) {
   double current_time = current_time_seconds();
   double elapsed = current_time - tqdm->start_time - tqdm->total_pause_time;
 
-  simple_dict.n = tqdm->n;
-  simple_dict.total = tqdm->params.total;
+  simple_dict.n = __atomic_load_n(&tqdm->n, __ATOMIC_RELAXED);
+  simple_dict.total = tqdm_live_total(tqdm);
   simple_dict.elapsed = elapsed;
   simple_dict.elapsed_s = elapsed;
-  simple_dict.rate = elapsed > 0 ? (double)tqdm->n / elapsed : 0.0;
-  simple_dict.percentage =
-      tqdm->params.total > 0 ? (100.0 * tqdm->n) / tqdm->params.total : 0.0;
+  simple_dict.rate = elapsed > 0 ? (double)simple_dict.n / elapsed : 0.0;
+  simple_dict.percentage = simple_dict.total > 0
+                               ? (100.0 * simple_dict.n) / simple_dict.total
+                               : 0.0;
   simple_dict.ncols = get_terminal_width();
   simple_dict.nrows = get_terminal_height();
   simple_dict.unit_divisor = tqdm->params.unit_divisor;
@@ -199,135 +463,24 @@ void tqdm_update_dynamic_miniters(tqdm_t *tqdm) {
 /* =============================
  * Formatting helpers
  * ============================= */
-static char *fast_format_int(long long num, char *buffer, size_t size) {
-  if (num == 0) {
-    strncpy(buffer, "0", size);
-    return buffer;
-  }
-
-  char temp[32];
-  char *p = temp + sizeof(temp) - 1;
-  *p = '\0';
-
-  bool negative = num < 0;
-  if (negative)
-    num = -num;
-
-  while (num > 0) {
-    *--p = '0' + (num % 10);
-    num /= 10;
-  }
-
-  if (negative)
-    *--p = '-';
-
-  strncpy(buffer, p, size);
-  return buffer;
-}
-
 char *tqdm_format_sizeof(double num, const char *suffix, int divisor) {
-  static const char *prefixes[] = {"",  "k", "M", "G", "T",
-                                   "P", "E", "Z", "Y"};
-  int prefix_idx = 0;
-
-  if (divisor == 1024) {
-    while (num >= 1024.0 && prefix_idx < 8) {
-      num /= 1024.0;
-      prefix_idx++;
-    }
-  } else {
-    while (num >= divisor && prefix_idx < 8) {
-      num /= divisor;
-      prefix_idx++;
-    }
-  }
-
   char *result = malloc(64);
-  const char *suffix_str = suffix ? suffix : "";
-
-  if (num == (double)(long long)num && num < 1000000) {
-    snprintf(result, 64, "%lld%s%s", (long long)num, prefixes[prefix_idx],
-             suffix_str);
-  } else if (num >= 100 || prefix_idx == 0) {
-    snprintf(result, 64, "%.0f%s%s", num, prefixes[prefix_idx], suffix_str);
-  } else if (num >= 10) {
-    snprintf(result, 64, "%.1f%s%s", num, prefixes[prefix_idx], suffix_str);
-  } else {
-    snprintf(result, 64, "%.2f%s%s", num, prefixes[prefix_idx], suffix_str);
-  }
-
+  if (result)
+    tqdm_fmt_sizeof(result, 64, num, suffix, divisor);
   return result;
 }
 
 char *tqdm_format_interval(double t) {
-  if (t < 0 || t > 86400 * 365) {
-    char *result = malloc(2);
-    strcpy(result, "?");
-    return result;
-  }
-
-  int total_seconds = (int)t;
-  int hours = total_seconds / 3600;
-  int minutes = (total_seconds % 3600) / 60;
-  int seconds = total_seconds % 60;
-
-  if (hours > 99999)
-    hours = 99999;
-  if (minutes > 59)
-    minutes = 59;
-  if (seconds > 59)
-    seconds = 59;
-
   char *result = malloc(16);
-
-  if (hours > 0) {
-    snprintf(result, 16, "%02d:%02d:%02d", hours, minutes, seconds);
-  } else {
-    snprintf(result, 16, "%02d:%02d", minutes, seconds);
-  }
-
+  if (result)
+    tqdm_fmt_interval(result, 16, t);
   return result;
 }
 
 char *tqdm_format_num(double n) {
   char *result = malloc(32);
-
-  /* Human‐readable suffix formatting: k (thousand), m (million), b (billion),
-   * t (trillion). For numbers beyond 1e15 we fall back to scientific notation
-   */
-  double absn = fabs(n);
-  const char *suffix = "";
-  double scaled = n;
-  if (absn >= 1e12 && absn < 1e15) {
-    suffix = "t";
-    scaled = n / 1e12;
-  } else if (absn >= 1e9) {
-    suffix = "b";
-    scaled = n / 1e9;
-  } else if (absn >= 1e6) {
-    suffix = "m";
-    scaled = n / 1e6;
-  } else if (absn >= 1e3) {
-    suffix = "k";
-    scaled = n / 1e3;
-  }
-
-  if (suffix[0] != '\0') {
-    if (fabs(scaled) >= 100) {
-      snprintf(result, 32, "%.0f%s", scaled, suffix);
-    } else if (fabs(scaled) >= 10) {
-      snprintf(result, 32, "%.1f%s", scaled, suffix);
-    } else {
-      snprintf(result, 32, "%.2f%s", scaled, suffix);
-    }
-  } else if (absn < 1000 && n == (double)(long long)n) {
-    fast_format_int((long long)n, result, 32);
-  } else if (absn < 1e15) {
-    snprintf(result, 32, "%.0f", n);
-  } else {
-    snprintf(result, 32, "%.3g", n);
-  }
-
+  if (result)
+    tqdm_fmt_num(result, 32, n);
   return result;
 }
 
@@ -337,159 +490,49 @@ char *tqdm_format_meter(size_t n, size_t total, double elapsed, int ncols,
                         const char *postfix, int unit_divisor, size_t initial,
                         const char *colour) {
   (void)initial;
-  (void)colour;
-
-  char *result = NULL;
-
-  if (bar_format && strlen(bar_format) > 0) {
-    result = malloc(256);
-    snprintf(result, 256, "%s: %zu/%zu [%.1fs, %.1fit/s] %s",
-             prefix ? prefix : "", n, total, elapsed, rate,
-             postfix ? postfix : "");
-    return result;
-  }
-
-  double percentage = total > 0 ? (100.0 * n) / total : 0.0;
-  if (percentage > 100.0)
-    percentage = 100.0;
-
-  char *remaining_str;
-  if (total > 0 && n > 0 && rate > 0 && n < total) {
-    double remaining = (total - n) / rate;
-    remaining_str = tqdm_format_interval(remaining);
-  } else {
-    remaining_str = malloc(2);
-    strcpy(remaining_str, "?");
-  }
-
-  char *elapsed_str = tqdm_format_interval(elapsed);
-
-  char *n_str, *total_str, *rate_str;
-  if (unit_scale) {
-    n_str = tqdm_format_sizeof((double)n, unit, unit_divisor);
-    if (total > 0) {
-      total_str = tqdm_format_sizeof((double)total, unit, unit_divisor);
-    } else {
-      total_str = malloc(2);
-      strcpy(total_str, "?");
-    }
-    if (rate <= 0) {
-      rate_str = malloc(2);
-      strcpy(rate_str, "?");
-    } else {
-      rate_str = tqdm_format_sizeof(rate, unit, unit_divisor);
-    }
-  } else {
-    n_str = tqdm_format_num((double)n);
-    if (total > 0) {
-      total_str = tqdm_format_num((double)total);
-    } else {
-      total_str = malloc(2);
-      strcpy(total_str, "?");
-    }
-    if (rate <= 0) {
-      rate_str = malloc(2);
-      strcpy(rate_str, "?");
-    } else {
-      rate_str = tqdm_format_num(rate);
-    }
-  }
-
-  int estimated_fixed = 50;
-  if (prefix)
-    estimated_fixed += strlen(prefix);
-  if (postfix)
-    estimated_fixed += strlen(postfix);
-
-  int bar_width = (ncols > estimated_fixed) ? (ncols - estimated_fixed) : 10;
-  if (bar_width < 1)
-    bar_width = 1;
-  if (bar_width > 100)
-    bar_width = 100;
-
-  char *bar = malloc(bar_width * 4 + 1);
-
-  if (ascii) {
-    int filled = total > 0 ? (int)((double)bar_width * n / total) : 0;
-    if (filled > bar_width)
-      filled = bar_width;
-
-    memset(bar, '#', filled);
-    memset(bar + filled, ' ', bar_width - filled);
-    bar[bar_width] = '\0';
-  } else {
-    bar[0] = '\0';
-
-    if (total > 0 && n > 0) {
-      int progress_fixed = (int)((n * 8 * bar_width) / total);
-      int filled_full = progress_fixed / 8;
-      int partial = progress_fixed % 8;
-
-      if (filled_full > bar_width) {
-        filled_full = bar_width;
-        partial = 0;
-      }
-
-      char *bar_ptr = bar;
-
-      for (int i = 0; i < filled_full && i < bar_width; i++) {
-        strcpy(bar_ptr, tqdm_unicode_blocks[8]);
-        bar_ptr += strlen(tqdm_unicode_blocks[8]);
-      }
-
-      if (filled_full < bar_width && partial > 0) {
-        strcpy(bar_ptr, tqdm_unicode_blocks[partial]);
-        bar_ptr += strlen(tqdm_unicode_blocks[partial]);
-        filled_full++;
-      }
-
-      for (int i = filled_full; i < bar_width; i++) {
-        strcpy(bar_ptr, tqdm_unicode_blocks[0]);
-        bar_ptr += strlen(tqdm_unicode_blocks[0]);
-      }
-    } else {
-      char *bar_ptr = bar;
-      for (int i = 0; i < bar_width; i++) {
-        strcpy(bar_ptr, tqdm_unicode_blocks[0]);
-        bar_ptr += strlen(tqdm_unicode_blocks[0]);
-      }
-    }
-  }
-
-  result = malloc(1024);
-
-  const char *desc_part = prefix && strlen(prefix) > 0 ? prefix : "";
-  const char *desc_sep = prefix && strlen(prefix) > 0 ? ": " : "";
-  const char *unit_str = unit ? unit : "it";
-  const char *rate_unit_suffix = unit_scale ? "" : unit_str;
-  const char *postfix_sep = postfix && strlen(postfix) > 0 ? " " : "";
-  const char *postfix_str = postfix ? postfix : "";
-
-  snprintf(result, 1024, "%s%s%3.0f%%|%s| %s/%s [%s<%s, %s%s/s]%s%s",
-           desc_part, desc_sep, percentage, bar, n_str, total_str,
-           elapsed_str, remaining_str, rate_str, rate_unit_suffix,
-           postfix_sep, postfix_str);
-
-  free(bar);
-  free(remaining_str);
-  free(elapsed_str);
-  free(n_str);
-  free(total_str);
-  free(rate_str);
 
+  tqdm_params_t params;
+  memset(&params, 0, sizeof(params));
+  params.ascii = ascii;
+  params.unit = (char *)unit;
+  params.unit_scale = unit_scale;
+  params.bar_format = (char *)bar_format;
+  params.unit_divisor = (float)unit_divisor;
+  params.colour = (char *)colour;
+
+  tqdm_style_t style;
+  tqdm_style_setup(&style, &params);
+
+  tqdm_meter_t meter = {
+      .n = n,
+      .total = total,
+      .total_estimate = total,
+      .elapsed = elapsed,
+      .rate = rate,
+      .remaining = (total > 0 && n > 0 && rate > 0 && n < total)
+                       ? (total - n) / rate
+                       : -1.0,
+      .desc = prefix,
+      .postfix = postfix,
+      .ncols = ncols,
+  };
+
+  char *result = malloc(1024);
+  if (result)
+    tqdm_render_meter(result, 1024, &meter, &style);
   return result;
 }
 
 /* Postfix functions */
 void tqdm_set_postfix(tqdm_t *tqdm, postfix_entry_t *postfix) {
-  if (tqdm->params.postfix) {
-    free(tqdm->params.postfix);
+  if (!postfix) {
     tqdm->params.postfix = NULL;
+    return;
   }
 
-  if (postfix) {
-    tqdm->params.postfix = postfix_format(postfix);
-  }
+  char *formatted = postfix_format(postfix);
+  tqdm_assign_str(tqdm, TQDM_STR_POSTFIX, &tqdm->params.postfix, formatted);
+  free(formatted);
 }
 
 /* Postfix dictionary */
@@ -575,84 +618,125 @@ void postfix_destroy(postfix_entry_t *head) {
   }
 }
 
-/* Creation functions */
-tqdm_t *tqdm_create(void *begin, void *end, size_t element_size) {
-  tqdm_params_t params = tqdm_default_params();
-  tqdm_t *result = tqdm_create_with_params(begin, end, element_size, &params);
-  tqdm_cleanup_params(&params);
-  return result;
+/* =============================
+ * Bar storage
+ * =============================
+ * A bar owns up to TQDM_STR_COUNT strings. Short ones are bump-allocated
+ * from the inline arena inside tqdm_t, so bars in caller storage
+ * (tqdm_init) never touch the heap; longer ones spill to malloc.
+ */
+static bool tqdm_str_is_inline(const tqdm_t *tqdm, const char *buf) {
+  return buf >= tqdm->str_inline &&
+         buf < tqdm->str_inline + sizeof(tqdm->str_inline);
 }
 
-tqdm_t *tqdm_create_with_total(void *begin, size_t total,
-                               size_t element_size) {
-  tqdm_params_t params = tqdm_default_params();
-  params.total = total;
-  tqdm_t *result =
-      tqdm_create_with_params(begin, NULL, element_size, &params);
-  tqdm_cleanup_params(&params);
-  return result;
+/* Copy src into the bar-owned buffer for slot, growing it only if needed.
+ * *field is pointed at the buffer, or set to NULL when src is NULL. */
+static bool tqdm_assign_str(tqdm_t *tqdm, int slot, char **field,
+                            const char *src) {
+  if (!src) {
+    *field = NULL;
+    return true;
+  }
+  if (src == tqdm->str_buf[slot]) {
+    *field = tqdm->str_buf[slot];
+    return true;
+  }
+
+  size_t len = strlen(src) + 1;
+  if (len > tqdm->str_cap[slot]) {
+    size_t arena_left = sizeof(tqdm->str_inline) - tqdm->str_inline_used;
+    char *buf;
+    size_t cap;
+
+    if (len <= arena_left) {
+      buf = tqdm->str_inline + tqdm->str_inline_used;
+      cap = len;
+      tqdm->str_inline_used += len;
+    } else {
+      cap = (len + 31) & ~(size_t)31;
+      if (tqdm_str_is_inline(tqdm, tqdm->str_buf[slot]))
+        buf = malloc(cap);
+      else
+        buf = realloc(tqdm->str_buf[slot], cap);
+      if (!buf) {
+        *field = NULL;
+        return false;
+      }
+    }
+    tqdm->str_buf[slot] = buf;
+    tqdm->str_cap[slot] = cap;
+  }
+  memcpy(tqdm->str_buf[slot], src, len);
+  *field = tqdm->str_buf[slot];
+  return true;
 }
 
-tqdm_t *tqdm_create_with_params(void *begin, void *end, size_t element_size,
-                                tqdm_params_t *user_params) {
-  tqdm_t *tqdm = calloc(1, sizeof(tqdm_t));
-  if (!tqdm)
-    return NULL;
-
-  tqdm->params = *user_params;
-
-  if (user_params->desc) {
-    tqdm->params.desc = strdup(user_params->desc);
-    if (!tqdm->params.desc)
-      goto cleanup_and_fail;
-  } else {
-    tqdm->params.desc = NULL;
-  }
+/* State allocated for the features a bar turned out to use */
+static void tqdm_release_state(tqdm_t *tqdm) {
+  free(tqdm->discovery_state);
+  tqdm->discovery_state = NULL;
+  free(tqdm->rate_range);
+  tqdm->rate_range = NULL;
+  tqdm_history_end(tqdm);
+}
 
-  if (user_params->unit) {
-    tqdm->params.unit = strdup(user_params->unit);
-    if (!tqdm->params.unit)
-      goto cleanup_and_fail;
-  } else {
-    tqdm->params.unit = NULL;
+static void tqdm_release_storage(tqdm_t *tqdm) {
+  tqdm_release_state(tqdm);
+  for (int i = 0; i < TQDM_STR_COUNT; i++) {
+    if (!tqdm_str_is_inline(tqdm, tqdm->str_buf[i]))
+      free(tqdm->str_buf[i]);
+    tqdm->str_buf[i] = NULL;
+    tqdm->str_cap[i] = 0;
   }
+  pthread_mutex_destroy(&tqdm->lock);
+}
 
-  if (user_params->ascii) {
-    tqdm->params.ascii = user_params->ascii; /* Create a boolean copy */
-  } else {
-    tqdm->params.ascii = false;
-  }
+/* Quantiles for {eta_range}, from the current phase on; without memory
+ * the range stays unknown */
+static void tqdm_rate_range_begin(tqdm_t *tqdm) {
+  if (!tqdm->rate_range &&
+      !(tqdm->rate_range = malloc(sizeof(*tqdm->rate_range))))
+    return;
+  tqdm_quantile_init(&tqdm->rate_range->low, TQDM_ETA_RANGE_LOW);
+  tqdm_quantile_init(&tqdm->rate_range->high, TQDM_ETA_RANGE_HIGH);
+}
 
-  if (user_params->bar_format) {
-    tqdm->params.bar_format = strdup(user_params->bar_format);
-    if (!tqdm->params.bar_format)
-      goto cleanup_and_fail;
-  } else {
-    tqdm->params.bar_format = NULL;
+/* Fill in a zeroed (or recycled) bar from params; NULL means defaults.
+ * With a style, the style's strings are referenced rather than copied. */
+static tqdm_t *tqdm_setup(tqdm_t *tqdm, void *begin, void *end,
+                          size_t element_size,
+                          const tqdm_params_t *user_params,
+                          tqdm_style_t *style) {
+  tqdm_params_t defaults;
+  if (!user_params) {
+    defaults = tqdm_static_default_params();
+    user_params = &defaults;
   }
 
-  if (user_params->colour) {
-    tqdm->params.colour = strdup(user_params->colour);
-    if (!tqdm->params.colour)
-      goto cleanup_and_fail;
-  } else {
-    tqdm->params.colour = NULL;
-  }
-
-  if (user_params->postfix) {
-    tqdm->params.postfix = strdup(user_params->postfix);
-    if (!tqdm->params.postfix)
-      goto cleanup_and_fail;
-  } else {
-    tqdm->params.postfix = NULL;
-  }
+  tqdm->params = *user_params;
 
-  tqdm_load_env_vars(&tqdm->params);
+  if (!tqdm_assign_str(tqdm, TQDM_STR_DESC, &tqdm->params.desc,
+                       user_params->desc) ||
+      (!style &&
+       (!tqdm_assign_str(tqdm, TQDM_STR_UNIT, &tqdm->params.unit,
+                         user_params->unit) ||
+        !tqdm_assign_str(tqdm, TQDM_STR_BAR_FORMAT, &tqdm->params.bar_format,
+                         user_params->bar_format) ||
+        !tqdm_assign_str(tqdm, TQDM_STR_COLOUR, &tqdm->params.colour,
+                         user_params->colour) ||
+        !tqdm_assign_str(tqdm, TQDM_STR_HISTORY_FILE,
+                         &tqdm->params.history_file,
+                         user_params->history_file))) ||
+      !tqdm_assign_str(tqdm, TQDM_STR_POSTFIX, &tqdm->params.postfix,
+                       user_params->postfix))
+    return NULL;
 
   if (tqdm->params.mininterval < 0) {
     tqdm->params.mininterval = 0.1f; /* Default to 0.1 seconds */
   }
-  if (tqdm->params.smoothing < 0 || tqdm->params.smoothing > 1) {
+  if (tqdm->params.smoothing != TQDM_SMOOTHING_AUTO &&
+      (tqdm->params.smoothing < 0 || tqdm->params.smoothing > 1)) {
     tqdm->params.smoothing = 0.3f; /* Default smoothing */
   }
   if (tqdm->params.unit_divisor <= 0) {
@@ -663,57 +747,253 @@ tqdm_t *tqdm_create_with_params(void *begin, void *end, size_t element_size,
   tqdm->end = end;
   tqdm->element_size = element_size;
   tqdm->count = 0;
-  tqdm->n = tqdm->params.initial;
+  __atomic_store_n(&tqdm->n, tqdm->params.initial, __ATOMIC_RELAXED);
+  __atomic_store_n(&tqdm->cost, 0, __ATOMIC_RELAXED);
+  tqdm->weighted = tqdm->params.cost_total > 0;
 
-  if (tqdm->params.total == 0 && begin && end && element_size > 0) {
+  if (tqdm_live_total(tqdm) == 0 && begin && end && element_size > 0) {
     size_t array_total = ((char *)end - (char *)begin) / element_size;
-    tqdm->params.total = array_total;
+    __atomic_store_n(&tqdm->params.total, array_total, __ATOMIC_RELAXED);
   }
-  tqdm->start_time = current_time_seconds();
-  tqdm->last_print_time = tqdm->start_time;
+  double start_time = current_time_seconds();
+  __atomic_store(&tqdm->start_time, &start_time, __ATOMIC_RELAXED);
+  tqdm->last_print_time = start_time;
   tqdm->last_print_count = tqdm->n;
-  tqdm->closed = false;
-  tqdm->paused = false;
-  tqdm->pause_start = 0.0;
-  tqdm->total_pause_time = 0.0;
+  __atomic_store(&tqdm->last_progress_time, &start_time, __ATOMIC_RELAXED);
+  tqdm->last_rate_calc_n = tqdm->n;
+  tqdm->muted = tqdm_output_discarded(tqdm->params.file);
+
+  if (!tqdm->params.estimator)
+    tqdm->params.estimator = tqdm->params.smoothing == TQDM_SMOOTHING_AUTO
+                                 ? &tqdm_estimator_ema
+                                 : &tqdm_estimator_linreg;
+  tqdm->params.estimator->reset(&tqdm->estimator_state, &tqdm->params);
+  tqdm->base_total = tqdm_live_total(tqdm);
+  tqdm_history_begin(tqdm, NULL);
+
+  /* Bars without a style share a compiled one for their look; without
+   * memory for it they fall back to compiling per frame */
+  if (style)
+    tqdm->style = tqdm_style_retain(style);
+  else if (!tqdm->params.disable)
+    tqdm->style = tqdm_style_for_params(&tqdm->params);
+
+  tqdm->rate_history_size = TQDM_RATE_HISTORY_SIZE;
+  if (tqdm_style_has_field(tqdm->style, TQDM_FIELD_ETA_RANGE))
+    tqdm_rate_range_begin(tqdm);
+  tqdm_change_reset(&tqdm->rate_change);
+  tqdm->cached_terminal_width = 80;
 
-  tqdm->rate_history_size = 10;
-  tqdm->rate_history = calloc(tqdm->rate_history_size, sizeof(double));
-  if (!tqdm->rate_history)
-    goto cleanup_and_fail;
-  tqdm->rate_history_idx = 0;
+  if ((tqdm->params.stall_timeout > 0 || tqdm->params.on_event) &&
+      !tqdm->params.disable)
+    tqdm_start_monitor(tqdm);
 
-  tqdm->cached_rate = 0.0;
-  tqdm->last_rate_calc_time = 0.0;
-  tqdm->last_rate_calc_n = 0;
-  tqdm->cached_terminal_width = 80;
-  tqdm->last_terminal_check = 0.0;
-  tqdm->display_buffer[0] = '\0';
+  return tqdm;
+}
+
+/* =============================
+ * Object pool
+ * =============================
+ * Bars are recycled through a small per-thread freelist. A pooled bar keeps
+ * its mutex and heap string buffers, so after warmup the create/destroy
+ * cycle of nested loops does not touch the allocator.
+ */
+typedef struct {
+  tqdm_t *head;
+  size_t size;
+} tqdm_pool_t;
+
+static __thread tqdm_pool_t tqdm_pool;
+static pthread_key_t tqdm_pool_key;
+static pthread_once_t tqdm_pool_once = PTHREAD_ONCE_INIT;
+
+static void tqdm_free_bar(tqdm_t *tqdm) {
+  tqdm_release_storage(tqdm);
+  free(tqdm);
+}
+
+static void tqdm_pool_drain(tqdm_pool_t *pool) {
+  while (pool->head) {
+    tqdm_t *next = pool->head->pool_next;
+    tqdm_free_bar(pool->head);
+    pool->head = next;
+  }
+  pool->size = 0;
+}
+
+/* Thread exit hook, registered the first time a thread pools a bar */
+static void tqdm_pool_thread_exit(void *pool) { tqdm_pool_drain(pool); }
+
+static void tqdm_pool_make_key(void) {
+  pthread_key_create(&tqdm_pool_key, tqdm_pool_thread_exit);
+}
+
+void tqdm_pool_trim(void) { tqdm_pool_drain(&tqdm_pool); }
+
+/* Take a bar from the pool (or the heap) with all state reset in place */
+static tqdm_t *tqdm_pool_acquire(void) {
+  tqdm_t *tqdm = tqdm_pool.head;
+
+  if (!tqdm) {
+    /* malloc only guarantees 16-byte alignment; the layout needs lines */
+    void *mem;
+    if (posix_memalign(&mem, TQDM_CACHELINE, sizeof(tqdm_t)) != 0)
+      return NULL;
+    tqdm = memset(mem, 0, sizeof(tqdm_t));
+    pthread_mutex_init(&tqdm->lock, NULL);
+    return tqdm;
+  }
 
+  tqdm_pool.head = tqdm->pool_next;
+  tqdm_pool.size--;
+
+  /* Keep the heap string buffers, zero the rest. Inline buffers are dropped
+   * since the arena starts over. A mutex may not be copied, so the
+   * (unlocked) one is destroyed and initialised again. */
+  char *str_buf[TQDM_STR_COUNT];
+  size_t str_cap[TQDM_STR_COUNT];
+  for (int i = 0; i < TQDM_STR_COUNT; i++) {
+    bool keep = !tqdm_str_is_inline(tqdm, tqdm->str_buf[i]);
+    str_buf[i] = keep ? tqdm->str_buf[i] : NULL;
+    str_cap[i] = keep ? tqdm->str_cap[i] : 0;
+  }
+  pthread_mutex_destroy(&tqdm->lock);
+
+  memset(tqdm, 0, sizeof(*tqdm));
+
+  memcpy(tqdm->str_buf, str_buf, sizeof(str_buf));
+  memcpy(tqdm->str_cap, str_cap, sizeof(str_cap));
   pthread_mutex_init(&tqdm->lock, NULL);
 
-  tqdm->iterator_mode = false;
-  tqdm->iterator_state = NULL;
+  return tqdm;
+}
 
-  if (tqdm->params.delay > 0) {
-    struct timespec delay_time;
-    delay_time.tv_sec = (time_t)tqdm->params.delay;
-    delay_time.tv_nsec =
-        (long)((tqdm->params.delay - delay_time.tv_sec) * 1e9);
-    nanosleep(&delay_time, NULL);
+static void tqdm_pool_release(tqdm_t *tqdm) {
+  tqdm_release_state(tqdm);
+  if (tqdm_pool.size >= TQDM_POOL_MAX) {
+    tqdm_free_bar(tqdm);
+    return;
   }
 
+  pthread_once(&tqdm_pool_once, tqdm_pool_make_key);
+  if (tqdm_pool.size == 0)
+    pthread_setspecific(tqdm_pool_key, &tqdm_pool);
+
+  tqdm->pool_next = tqdm_pool.head;
+  tqdm_pool.head = tqdm;
+  tqdm_pool.size++;
+}
+
+/* Creation functions */
+tqdm_t *tqdm_create(void *begin, void *end, size_t element_size) {
+  return tqdm_create_with_params(begin, end, element_size, NULL);
+}
+
+tqdm_t *tqdm_create_with_total(void *begin, size_t total,
+                               size_t element_size) {
+  tqdm_params_t params = tqdm_static_default_params();
+  params.total = total;
+  return tqdm_create_with_params(begin, NULL, element_size, &params);
+}
+
+tqdm_t *tqdm_create_with_params(void *begin, void *end, size_t element_size,
+                                tqdm_params_t *user_params) {
+  tqdm_t *tqdm = tqdm_pool_acquire();
+  if (!tqdm)
+    return NULL;
+
+  if (!tqdm_setup(tqdm, begin, end, element_size, user_params, NULL)) {
+    tqdm_pool_release(tqdm);
+    return NULL;
+  }
   return tqdm;
+}
 
-cleanup_and_fail:
-  free(tqdm->params.desc);
-  free(tqdm->params.unit);
-  free(tqdm->params.bar_format);
-  free(tqdm->params.colour);
-  free(tqdm->params.postfix);
-  free(tqdm->rate_history);
-  free(tqdm);
-  return NULL;
+/* Caller-storage initialisation */
+tqdm_t *tqdm_init(tqdm_t *storage, const tqdm_params_t *params) {
+  return tqdm_init_with_params(storage, NULL, NULL, 0, params);
+}
+
+tqdm_t *tqdm_init_with_total(tqdm_t *storage, void *begin, size_t total,
+                             size_t element_size) {
+  tqdm_params_t params = tqdm_static_default_params();
+  params.total = total;
+  return tqdm_init_with_params(storage, begin, NULL, element_size, &params);
+}
+
+tqdm_t *tqdm_init_with_params(tqdm_t *storage, void *begin, void *end,
+                              size_t element_size,
+                              const tqdm_params_t *params) {
+  if (!storage)
+    return NULL;
+
+  memset(storage, 0, sizeof(*storage));
+  pthread_mutex_init(&storage->lock, NULL);
+
+  if (!tqdm_setup(storage, begin, end, element_size, params, NULL)) {
+    tqdm_release_storage(storage);
+    return NULL;
+  }
+  return storage;
+}
+
+/* Styled bars: only the description and counters are per bar */
+tqdm_t *tqdm_create_with_style(tqdm_style_t *style, const char *desc,
+                               size_t total) {
+  if (!style)
+    return NULL;
+
+  tqdm_params_t params = style->params;
+  params.desc = (char *)desc;
+  params.total = total;
+
+  tqdm_t *tqdm = tqdm_pool_acquire();
+  if (!tqdm)
+    return NULL;
+
+  if (!tqdm_setup(tqdm, NULL, NULL, 0, &params, style)) {
+    tqdm_pool_release(tqdm);
+    return NULL;
+  }
+  return tqdm;
+}
+
+tqdm_t *tqdm_init_with_style(tqdm_t *storage, tqdm_style_t *style,
+                             const char *desc, size_t total) {
+  if (!storage || !style)
+    return NULL;
+
+  tqdm_params_t params = style->params;
+  params.desc = (char *)desc;
+  params.total = total;
+
+  memset(storage, 0, sizeof(*storage));
+  pthread_mutex_init(&storage->lock, NULL);
+
+  if (!tqdm_setup(storage, NULL, NULL, 0, &params, style)) {
+    tqdm_release_storage(storage);
+    return NULL;
+  }
+  return storage;
+}
+
+void tqdm_fini(tqdm_t *tqdm) {
+  if (!tqdm)
+    return;
+
+  if (!tqdm->closed) {
+    tqdm_close(tqdm);
+  }
+
+  if (tqdm->iterator_mode && tqdm->destroy_func) {
+    tqdm->destroy_func(tqdm->iterator_state);
+  }
+
+  if (tqdm->group)
+    tqdm_group_remove(tqdm->group, tqdm);
+  tqdm_style_release(tqdm->style);
+  tqdm->style = NULL;
+  tqdm_release_storage(tqdm);
 }
 
 tqdm_t *tqdm_create_iterator(void *iterator_state, void *(*next_func)(void *),
@@ -747,8 +1027,9 @@ bool tqdm_has_next(tqdm_t *tqdm) {
     return (char *)tqdm->current < (char *)tqdm->end;
   }
 
-  if (tqdm->params.total > 0) {
-    return tqdm->n < tqdm->params.total;
+  size_t total = tqdm_live_total(tqdm);
+  if (total > 0) {
+    return __atomic_load_n(&tqdm->n, __ATOMIC_RELAXED) < total;
   }
 
   return true;
@@ -758,10 +1039,23 @@ void *tqdm_next(tqdm_t *tqdm) {
   if (!tqdm_has_next(tqdm))
     return NULL;
 
-  pthread_mutex_lock(&tqdm->lock);
-
   void *result = NULL;
 
+  /* A disabled bar only iterates: no lock, no clock, no printing */
+  if (tqdm->params.disable) {
+    if (tqdm->iterator_mode) {
+      result = tqdm->next_func(tqdm->iterator_state);
+    } else {
+      result = tqdm->current;
+      tqdm->current = (char *)tqdm->current + tqdm->element_size;
+    }
+    tqdm->count++;
+    __atomic_store_n(&tqdm->n, tqdm->n + 1, __ATOMIC_RELAXED);
+    return result;
+  }
+
+  pthread_mutex_lock(&tqdm->lock);
+
   if (tqdm->iterator_mode) {
     result = tqdm->next_func(tqdm->iterator_state);
   } else {
@@ -770,15 +1064,22 @@ void *tqdm_next(tqdm_t *tqdm) {
   }
 
   tqdm->count++;
-  tqdm->n++;
+  __atomic_store_n(&tqdm->n, tqdm->n + 1, __ATOMIC_RELAXED);
+
+  /* Nobody can see the output: keep counting, skip the refresh logic */
+  if (tqdm->muted) {
+    tqdm_sample_muted(tqdm);
+    pthread_mutex_unlock(&tqdm->lock);
+    return result;
+  }
 
   tqdm_update_dynamic_miniters(tqdm);
 
   double current_time = current_time_seconds();
   bool should_print = false;
 
-  bool is_complete =
-      (tqdm->params.total > 0 && tqdm->n >= tqdm->params.total);
+  size_t total = tqdm_live_total(tqdm);
+  bool is_complete = total > 0 && tqdm->n >= total;
 
   if (is_complete ||
       (tqdm->params.miniters == 0 ||
@@ -789,7 +1090,7 @@ void *tqdm_next(tqdm_t *tqdm) {
     }
   }
 
-  if (should_print && !tqdm->params.disable) {
+  if (should_print) {
     tqdm_print_progress(tqdm);
   }
 
@@ -806,20 +1107,55 @@ void tqdm_update(tqdm_t *tqdm) {
 }
 
 void tqdm_update_n(tqdm_t *tqdm, size_t n) {
+  tqdm_update_weighted(tqdm, n, 0);
+}
+
+/* Finished by item count, or by cost for weighted bars */
+static bool tqdm_is_complete(const tqdm_t *tqdm) {
+  size_t total = tqdm_live_total(tqdm);
+  return (total > 0 && tqdm->n >= total) ||
+         (tqdm->weighted && tqdm->params.cost_total > 0 &&
+          tqdm->cost >= tqdm->params.cost_total);
+}
+
+/* Muted bars skip the refresh, but a history_file still records their
+ * real profile: sample it at the mininterval cadence. Caller holds the
+ * lock. */
+static void tqdm_sample_muted(tqdm_t *tqdm) {
+  if (!tqdm->history)
+    return;
+  double current_time = current_time_seconds();
+  if (current_time - tqdm->last_print_time < tqdm->params.mininterval)
+    return;
+  tqdm->last_print_time = current_time;
+  tqdm_history_sample(tqdm, current_time - tqdm->start_time -
+                                tqdm->total_pause_time);
+}
+
+void tqdm_update_weighted(tqdm_t *tqdm, size_t items, size_t cost) {
   if (!tqdm || tqdm->closed || tqdm->params.disable)
     return;
 
   pthread_mutex_lock(&tqdm->lock);
 
-  tqdm->n += n;
+  __atomic_store_n(&tqdm->n, tqdm->n + items, __ATOMIC_RELAXED);
+  if (cost > 0) {
+    __atomic_store_n(&tqdm->cost, tqdm->cost + cost, __ATOMIC_RELAXED);
+    tqdm->weighted = true;
+  }
+
+  if (tqdm->muted) {
+    tqdm_sample_muted(tqdm);
+    pthread_mutex_unlock(&tqdm->lock);
+    return;
+  }
 
   tqdm_update_dynamic_miniters(tqdm);
 
   double current_time = current_time_seconds();
   bool should_print = false;
 
-  bool is_complete =
-      (tqdm->params.total > 0 && tqdm->n >= tqdm->params.total);
+  bool is_complete = tqdm_is_complete(tqdm);
 
   if (is_complete ||
       (tqdm->params.miniters == 0 ||
@@ -844,15 +1180,20 @@ bool tqdm_update_to(tqdm_t *tqdm, size_t n) {
   pthread_mutex_lock(&tqdm->lock);
 
   size_t delta = (n > tqdm->n) ? (n - tqdm->n) : 0;
-  tqdm->n = n;
+  __atomic_store_n(&tqdm->n, n, __ATOMIC_RELAXED);
+
+  if (tqdm->muted) {
+    tqdm_sample_muted(tqdm);
+    pthread_mutex_unlock(&tqdm->lock);
+    return false;
+  }
 
   tqdm_update_dynamic_miniters(tqdm);
 
   double current_time = current_time_seconds();
   bool should_print = false;
 
-  bool is_complete =
-      (tqdm->params.total > 0 && tqdm->n >= tqdm->params.total);
+  bool is_complete = tqdm_is_complete(tqdm);
 
   if (is_complete ||
       (tqdm->params.miniters == 0 || delta >= tqdm->params.miniters)) {
@@ -871,26 +1212,96 @@ bool tqdm_update_to(tqdm_t *tqdm, size_t n) {
   return should_print;
 }
 
+void tqdm_add_total(tqdm_t *tqdm, size_t delta) {
+  if (!tqdm || delta == 0)
+    return;
+
+  __atomic_add_fetch(&tqdm->params.total, delta, __ATOMIC_RELAXED);
+  if (!tqdm_live_growing(tqdm))
+    __atomic_store_n(&tqdm->growing, true, __ATOMIC_RELAXED);
+}
+
+/* Start the rate model, with the quantiles and change test that describe
+ * the same rates, afresh from a point of the run: a new phase or a new
+ * rate regime */
+static void tqdm_rate_restart(tqdm_t *tqdm, double elapsed, size_t progress) {
+  double unknown = 0.0;
+  tqdm->rate_origin_time = elapsed;
+  tqdm->rate_origin_n = progress;
+  tqdm->params.estimator->reset(&tqdm->estimator_state, &tqdm->params);
+  __atomic_store(&tqdm->cached_rate, &unknown, __ATOMIC_RELAXED);
+  if (tqdm->rate_range)
+    tqdm_rate_range_begin(tqdm);
+  tqdm_change_reset(&tqdm->rate_change);
+}
+
+void tqdm_phase_begin(tqdm_t *tqdm, const char *name,
+                      double expected_fraction) {
+  if (!tqdm || tqdm->closed || tqdm->params.disable)
+    return;
+
+  pthread_mutex_lock(&tqdm->lock);
+
+  size_t progress = tqdm->weighted ? tqdm->cost : tqdm->n;
+  size_t total = tqdm->weighted
+                     ? tqdm->params.cost_total
+                     : tqdm_live_total(tqdm);
+  size_t end = 0;
+  if (expected_fraction > 0 && total > progress) {
+    double end_at = progress + expected_fraction * total;
+    end = end_at < total ? (size_t)llround(end_at) : total;
+  }
+
+  tqdm->phase_end_n = end;
+  tqdm->phased = true;
+  tqdm_assign_str(tqdm, TQDM_STR_PHASE, &tqdm->phase_name, name);
+  tqdm_rate_restart(tqdm,
+                    current_time_seconds() - tqdm->start_time -
+                        tqdm->total_pause_time,
+                    progress);
+  tqdm_print_progress(tqdm);
+
+  pthread_mutex_unlock(&tqdm->lock);
+}
+
 /* Core methods */
 void tqdm_close(tqdm_t *tqdm) {
   if (!tqdm || tqdm->closed)
     return;
 
+  /* Before taking the lock: a running stall callback may want it */
+  tqdm_stop_monitor(tqdm);
+
   pthread_mutex_lock(&tqdm->lock);
 
-  tqdm_stop_monitor(tqdm);
+  uint64_t history_key;
+  float history_marks[TQDM_HISTORY_MARKS];
+  bool store_history =
+      !tqdm->params.disable &&
+      tqdm_history_finish(tqdm,
+                          current_time_seconds() - tqdm->start_time -
+                              tqdm->total_pause_time,
+                          &history_key, history_marks);
 
   if (tqdm->params.leave && !tqdm->params.disable) {
     tqdm_print_progress(tqdm);
-    fprintf(tqdm->params.file, "\n");
-    fflush(tqdm->params.file);
-  } else if (!tqdm->params.leave) {
+    /* Still inside the initial delay: the bar never appeared */
+    if (tqdm->displayed) {
+      fprintf(tqdm->params.file, "\n");
+      fflush(tqdm->params.file);
+    }
+  } else if (!tqdm->params.leave && tqdm->displayed) {
     tqdm_clear(tqdm);
   }
 
   tqdm->closed = true;
 
   pthread_mutex_unlock(&tqdm->lock);
+
+  /* May wait on another job's flock: not under the bar's lock */
+  if (store_history)
+    tqdm_history_store(tqdm->params.history_file, history_key,
+                       history_marks);
 }
 
 void tqdm_clear(tqdm_t *tqdm) {
@@ -915,28 +1326,57 @@ void tqdm_unpause(tqdm_t *tqdm) {
     return;
 
   double current_time = current_time_seconds();
-  tqdm->total_pause_time += current_time - tqdm->pause_start;
+  double paused = tqdm->total_pause_time + current_time - tqdm->pause_start;
+  __atomic_store(&tqdm->total_pause_time, &paused, __ATOMIC_RELAXED);
   tqdm->paused = false;
   tqdm->pause_start = 0.0;
 }
 
 void tqdm_reset(tqdm_t *tqdm, size_t total) {
+  /* The next run's prior is read before the reset takes the lock */
+  tqdm_history_prior_t prior = {0};
+  if (tqdm->params.history_file) {
+    pthread_mutex_lock(&tqdm->lock);
+    prior.key = tqdm_history_key(
+        tqdm->params.desc, total > 0 ? total : tqdm_live_total(tqdm),
+        tqdm->params.cost_total);
+    pthread_mutex_unlock(&tqdm->lock);
+    prior.valid =
+        tqdm_history_load(tqdm->params.history_file, prior.key, prior.marks);
+  }
+
   pthread_mutex_lock(&tqdm->lock);
 
-  tqdm->n = tqdm->params.initial;
+  __atomic_store_n(&tqdm->n, tqdm->params.initial, __ATOMIC_RELAXED);
+  __atomic_store_n(&tqdm->cost, 0, __ATOMIC_RELAXED);
+  tqdm->weighted = tqdm->params.cost_total > 0;
   tqdm->count = 0;
-  tqdm->start_time = current_time_seconds();
-  tqdm->last_print_time = tqdm->start_time;
+  double start_time = current_time_seconds(), unpaused = 0.0;
+  __atomic_store(&tqdm->start_time, &start_time, __ATOMIC_RELAXED);
+  tqdm->last_print_time = start_time;
   tqdm->last_print_count = tqdm->n;
-  tqdm->total_pause_time = 0.0;
+  __atomic_store(&tqdm->last_progress_time, &start_time, __ATOMIC_RELAXED);
+  __atomic_store(&tqdm->total_pause_time, &unpaused, __ATOMIC_RELAXED);
   tqdm->paused = false;
 
   if (total > 0) {
-    tqdm->params.total = total;
+    __atomic_store_n(&tqdm->params.total, total, __ATOMIC_RELAXED);
   }
 
   memset(tqdm->rate_history, 0, tqdm->rate_history_size * sizeof(double));
   tqdm->rate_history_idx = 0;
+  tqdm_rate_restart(tqdm, 0.0, 0);
+  if (tqdm->discovery_state)
+    tqdm->params.estimator->reset(tqdm->discovery_state, &tqdm->params);
+  tqdm->cached_discovery_rate = 0.0;
+  tqdm->last_rate_calc_time = 0.0;
+  tqdm->last_rate_calc_n = tqdm->n;
+  __atomic_store_n(&tqdm->growing, false, __ATOMIC_RELAXED);
+  tqdm->base_total = tqdm_live_total(tqdm);
+  tqdm->phase_end_n = 0;
+  tqdm->phased = false;
+  tqdm->phase_name = NULL;
+  tqdm_history_begin(tqdm, &prior);
 
   pthread_mutex_unlock(&tqdm->lock);
 }
@@ -951,10 +1391,7 @@ void tqdm_set_description_str(tqdm_t *tqdm, const char *desc, bool refresh) {
 
   pthread_mutex_lock(&tqdm->lock);
 
-  if (tqdm->params.desc) {
-    free(tqdm->params.desc);
-  }
-  tqdm->params.desc = desc ? strdup(desc) : NULL;
+  tqdm_assign_str(tqdm, TQDM_STR_DESC, &tqdm->params.desc, desc);
 
   if (refresh) {
     tqdm_print_progress(tqdm);
@@ -967,10 +1404,7 @@ void tqdm_set_postfix_str(tqdm_t *tqdm, const char *postfix, bool refresh) {
   if (!tqdm)
     return;
 
-  if (tqdm->params.postfix) {
-    free(tqdm->params.postfix);
-  }
-  tqdm->params.postfix = postfix ? strdup(postfix) : NULL;
+  tqdm_assign_str(tqdm, TQDM_STR_POSTFIX, &tqdm->params.postfix, postfix);
 
   if (refresh) {
     tqdm_refresh(tqdm);
@@ -1076,38 +1510,266 @@ void tqdm_destroy(tqdm_t *tqdm) {
     tqdm_close(tqdm);
   }
 
-  if (tqdm->params.desc)
-    free(tqdm->params.desc);
-  if (tqdm->params.unit)
-    free(tqdm->params.unit);
-  if (tqdm->params.bar_format)
-    free(tqdm->params.bar_format);
-  if (tqdm->params.colour)
-    free(tqdm->params.colour);
-  if (tqdm->params.postfix)
-    free(tqdm->params.postfix);
-
-  if (tqdm->rate_history) {
-    free(tqdm->rate_history);
-  }
-
   if (tqdm->iterator_mode && tqdm->destroy_func) {
     tqdm->destroy_func(tqdm->iterator_state);
   }
 
-  pthread_mutex_destroy(&tqdm->lock);
+  if (tqdm->group)
+    tqdm_group_remove(tqdm->group, tqdm);
+  tqdm_style_release(tqdm->style);
+  tqdm->style = NULL;
+  tqdm_pool_release(tqdm);
+}
 
-  free(tqdm);
+/* Throughput for {sparkline}, {eta_range} and change detection: the rate
+ * over each stretch of at least mininterval. A shift in it restarts the
+ * rate model from the start of the interval that showed it, seeded with
+ * that interval, and is reported by the monitor. */
+static void tqdm_rate_history_sample(tqdm_t *tqdm, double elapsed) {
+  size_t progress = tqdm->weighted ? tqdm->cost : tqdm->n;
+  double dt = elapsed - tqdm->last_rate_calc_time;
+  if (dt <= 0 || dt < tqdm->params.mininterval)
+    return;
+
+  size_t done = progress >= tqdm->last_rate_calc_n
+                    ? progress - tqdm->last_rate_calc_n
+                    : 0;
+  double rate = done / dt;
+  tqdm->rate_history[tqdm->rate_history_idx % tqdm->rate_history_size] = rate;
+  tqdm->rate_history_idx++;
+
+  if (tqdm_change_add(&tqdm->rate_change, rate)) {
+    tqdm_rate_restart(tqdm, tqdm->last_rate_calc_time,
+                      tqdm->last_rate_calc_n);
+    tqdm_change_add(&tqdm->rate_change, rate);
+    const tqdm_estimator_t *est = tqdm->params.estimator;
+    est->sample(&tqdm->estimator_state, dt, (double)done);
+    double seeded = est->rate(&tqdm->estimator_state);
+    __atomic_store(&tqdm->cached_rate, &seeded, __ATOMIC_RELAXED);
+    __atomic_store_n(&tqdm->rate_changed, true, __ATOMIC_RELEASE);
+  }
+  if (tqdm->rate_range) {
+    tqdm_quantile_add(&tqdm->rate_range->low, rate);
+    tqdm_quantile_add(&tqdm->rate_range->high, rate);
+  }
+  tqdm->last_rate_calc_time = elapsed;
+  tqdm->last_rate_calc_n = progress;
+}
+
+/* A growing total is a queue: work arrives at the discovery rate and
+ * leaves at the processing rate, so it drains in backlog / (rate -
+ * discovery) and ends at the total plus what arrives meanwhile. While
+ * discovery keeps up with processing neither is known. */
+static void tqdm_growing_estimate(const tqdm_t *tqdm, size_t n, size_t total,
+                                  double rate, tqdm_meter_t *meter) {
+  double discovery;
+  __atomic_load(&tqdm->cached_discovery_rate, &discovery, __ATOMIC_RELAXED);
+  if (discovery <= 0)
+    return;
+
+  if (rate <= discovery) {
+    meter->remaining = -1.0;
+    meter->total_estimate = 0;
+    return;
+  }
+  double left = n < total ? (double)(total - n) / (rate - discovery) : 0.0;
+  meter->remaining = left;
+  meter->total_estimate = total + (size_t)llround(discovery * left);
+}
+
+/* Phased ETA: the rest of the current phase at its own rate, then the
+ * phases to come at the pace the run history recorded for that stretch,
+ * or at the run's average rate without history */
+static double tqdm_phase_remaining(const tqdm_t *tqdm, size_t n, size_t total,
+                                   double elapsed, double rate) {
+  size_t end = tqdm->phase_end_n;
+  if (end == 0 || end > total)
+    end = total;
+  double left = end > n ? (end - n) / rate : 0.0;
+
+  size_t from = n > end ? n : end;
+  if (from >= total)
+    return left;
+  double later = tqdm_history_span(tqdm, (double)from / total, 1.0);
+  if (later < 0)
+    later = (total - from) / (elapsed > 1e-6 ? n / elapsed : rate);
+  return left + later;
+}
+
+/* {eta_range}: the ETA rescaled to the phase's 90th and 10th percentile
+ * interval rates, widened to include the ETA itself. A low quantile of
+ * zero (intervals with no progress) leaves the upper end open. */
+static void tqdm_eta_range(const tqdm_t *tqdm, double rate,
+                           tqdm_meter_t *meter) {
+  meter->remaining_low = meter->remaining_high = -1.0;
+  if (!tqdm->rate_range)
+    return;
+  double high = tqdm_quantile_value(&tqdm->rate_range->high);
+  double low = tqdm_quantile_value(&tqdm->rate_range->low);
+  if (meter->remaining < 0 || rate <= 0 || high <= 0)
+    return;
+
+  double eta = meter->remaining;
+  meter->remaining_low = fmin(eta, eta * rate / high);
+  if (low > 0)
+    meter->remaining_high = fmax(eta, eta * rate / low);
+}
+
+/* Per-frame values for the renderer, with the bar's lock held. Weighted
+ * bars measure progress in cost and carry the item count on the side. */
+void tqdm_sample_meter(const tqdm_t *tqdm, double now, int ncols,
+                       tqdm_meter_t *meter) {
+  size_t n = __atomic_load_n(&tqdm->n, __ATOMIC_RELAXED);
+  size_t total = tqdm_live_total(tqdm);
+  meter->weighted = tqdm->weighted;
+  if (meter->weighted) {
+    meter->items = n;
+    meter->items_total = total;
+    n = __atomic_load_n(&tqdm->cost, __ATOMIC_RELAXED);
+    total = tqdm->params.cost_total;
+  }
+  double elapsed = now - tqdm->start_time - tqdm->total_pause_time;
+  double rate;
+  __atomic_load(&tqdm->cached_rate, &rate, __ATOMIC_RELAXED);
+  if (rate <= 0) {
+    /* Average over the current phase (the whole run without phases) */
+    double phase_elapsed = elapsed - tqdm->rate_origin_time;
+    size_t phase_n = n > tqdm->rate_origin_n ? n - tqdm->rate_origin_n : 0;
+    rate = (phase_elapsed > 1e-6) ? (double)phase_n / phase_elapsed : 0.0;
+  }
+
+  meter->n = n;
+  meter->total = total;
+  meter->elapsed = elapsed;
+  meter->rate = rate;
+  meter->remaining = (total > 0 && n > 0 && rate > 0 && n < total)
+                         ? (total - n) / rate
+                         : -1.0;
+  if (tqdm->phased && meter->remaining >= 0)
+    meter->remaining = tqdm_phase_remaining(tqdm, n, total, elapsed, rate);
+  meter->total_estimate = total;
+  if (!meter->weighted && tqdm_live_growing(tqdm))
+    tqdm_growing_estimate(tqdm, n, total, rate, meter);
+  if (total > 0)
+    meter->remaining = tqdm_history_remaining(tqdm, (double)n / total,
+                                              elapsed, meter->remaining);
+  tqdm_eta_range(tqdm, rate, meter);
+  meter->desc = tqdm->params.desc;
+  meter->postfix = tqdm->params.postfix;
+  meter->phase = tqdm->phase_name;
+  meter->ncols = ncols;
+
+  /* Stalled per the monitor, unless it has moved since the last scan */
+  meter->stalled_for = 0.0;
+  if (__atomic_load_n(&tqdm->stalled, __ATOMIC_ACQUIRE) &&
+      __atomic_load_n(&tqdm->monitor_n, __ATOMIC_RELAXED) ==
+          __atomic_load_n(&tqdm->n, __ATOMIC_RELAXED)) {
+    double since;
+    __atomic_load(&tqdm->monitor_progress_time, &since, __ATOMIC_RELAXED);
+    meter->stalled_for = now - since;
+  }
+
+  /* Oldest rate sample first */
+  size_t pushed = tqdm->rate_history_idx, size = tqdm->rate_history_size;
+  meter->spark_len = pushed < size ? pushed : size;
+  for (size_t i = 0; i < meter->spark_len; i++)
+    meter->spark[i] = tqdm->rate_history[(pushed - meter->spark_len + i) % size];
+}
+
+/* What a bar busy in another thread can show: its item count against the
+ * total at the average rate. The rate model, phases, history and strings
+ * change under the lock, so those fields stay empty. */
+void tqdm_sample_counters(const tqdm_t *tqdm, double now, int ncols,
+                          tqdm_meter_t *meter) {
+  size_t n = __atomic_load_n(&tqdm->n, __ATOMIC_RELAXED);
+  size_t total = tqdm_live_total(tqdm);
+  double elapsed = tqdm_live_elapsed(tqdm, now);
+  double rate = elapsed > 1e-6 ? (double)n / elapsed : 0.0;
+
+  meter->n = n;
+  meter->total = meter->total_estimate = total;
+  meter->items = meter->items_total = 0;
+  meter->weighted = false;
+  meter->elapsed = elapsed;
+  meter->rate = rate;
+  meter->remaining = (total > 0 && n > 0 && rate > 0 && n < total)
+                         ? (total - n) / rate
+                         : -1.0;
+  meter->remaining_low = meter->remaining_high = -1.0;
+  meter->desc = meter->postfix = meter->phase = NULL;
+  meter->ncols = ncols;
+  meter->spark_len = 0;
+  meter->stalled_for = 0.0;
+}
+
+/* Bars whose style could not be allocated compile a throwaway one per
+ * frame */
+const tqdm_style_t *tqdm_bar_style(const tqdm_t *tqdm, tqdm_style_t *local) {
+  if (tqdm->style)
+    return tqdm->style;
+  tqdm_style_setup(local, &tqdm->params);
+  return local;
+}
+
+/* The growth model of a total raised by tqdm_add_total, set up by the
+ * first refresh that sees it grow */
+static bool tqdm_discovery_begin(tqdm_t *tqdm) {
+  if (tqdm->discovery_state)
+    return true;
+  if (!(tqdm->discovery_state = malloc(sizeof(*tqdm->discovery_state))))
+    return false;
+  tqdm->params.estimator->reset(tqdm->discovery_state, &tqdm->params);
+  return true;
 }
 
 static void tqdm_print_progress(tqdm_t *tqdm) {
-  if (!tqdm || tqdm->params.disable || tqdm->closed)
+  if (!tqdm || tqdm->params.disable || tqdm->closed || tqdm->muted)
     return;
 
   double current_time = current_time_seconds();
+
+  if (tqdm->n != tqdm->last_print_count)
+    __atomic_store(&tqdm->last_progress_time, &current_time,
+                   __ATOMIC_RELAXED);
+
+  /* Feed the estimator at the refresh cadence, even while delayed. It
+   * sees the current phase only. */
+  const tqdm_estimator_t *est = tqdm->params.estimator;
   double elapsed = current_time - tqdm->start_time - tqdm->total_pause_time;
+  size_t progress = tqdm->weighted ? tqdm->cost : tqdm->n;
+  est->sample(&tqdm->estimator_state, elapsed - tqdm->rate_origin_time,
+              progress > tqdm->rate_origin_n
+                  ? (double)(progress - tqdm->rate_origin_n)
+                  : 0.0);
+  double rate = est->rate(&tqdm->estimator_state);
+  __atomic_store(&tqdm->cached_rate, &rate, __ATOMIC_RELAXED);
+  if (tqdm_live_growing(tqdm) &&
+      tqdm_discovery_begin(tqdm)) {
+    size_t total = tqdm_live_total(tqdm);
+    est->sample(tqdm->discovery_state, elapsed,
+                (double)(total - tqdm->base_total));
+    double discovery = est->rate(tqdm->discovery_state);
+    __atomic_store(&tqdm->cached_discovery_rate, &discovery,
+                   __ATOMIC_RELAXED);
+  }
+  tqdm_history_sample(tqdm, elapsed);
+  tqdm_rate_history_sample(tqdm, elapsed);
+
+  /* Group members are drawn by their dashboard */
+  if (tqdm->group) {
+    tqdm->last_print_time = current_time;
+    tqdm->last_print_count = tqdm->n;
+    tqdm_group_notify(tqdm->group, tqdm);
+    return;
+  }
 
-  double rate = (elapsed > 1e-6) ? (double)tqdm->n / elapsed : 0.0;
+  /* Initial delay: nothing is drawn until it has elapsed, so short tasks
+   * never show a bar. Keep the mininterval cadence while waiting. */
+  if (!tqdm->displayed && tqdm->params.delay > 0 &&
+      current_time - tqdm->start_time < tqdm->params.delay) {
+    tqdm->last_print_time = current_time;
+    return;
+  }
 
   int ncols = tqdm->params.ncols;
   if (ncols <= 0 || tqdm->params.dynamic_ncols) {
@@ -1120,23 +1782,23 @@ static void tqdm_print_progress(tqdm_t *tqdm) {
     }
   }
 
-  char *meter = tqdm_format_meter(
-      tqdm->n, tqdm->params.total, elapsed, ncols, tqdm->params.desc,
-      tqdm->params.ascii, tqdm->params.unit, tqdm->params.unit_scale, rate,
-      tqdm->params.bar_format, tqdm->params.postfix,
-      (int)tqdm->params.unit_divisor, tqdm->params.initial,
-      tqdm->params.colour);
+  tqdm_meter_t meter;
+  tqdm_sample_meter(tqdm, current_time, ncols, &meter);
 
-  if (meter) {
-    fprintf(tqdm->params.file, "\r%s", meter);
-    fflush(tqdm->params.file);
-    free(meter);
-  }
+  tqdm_style_t local;
+  char line[TQDM_LINE_SIZE];
+  tqdm_render_meter(line, sizeof(line), &meter, tqdm_bar_style(tqdm, &local));
+  fprintf(tqdm->params.file, "\r%s", line);
+  if (!tqdm_output_flush(tqdm->params.file))
+    tqdm->muted = true;
 
+  tqdm->displayed = true;
   tqdm->last_print_time = current_time;
   tqdm->last_print_count = tqdm->n;
 }
 
+void tqdm_redraw_locked(tqdm_t *tqdm) { tqdm_print_progress(tqdm); }
+
 /* Stub for pandas integration, TODO in the future? */
 void tqdm_pandas_register(tqdm_params_t *params) { (void)params; }
 
@@ -1151,10 +1813,15 @@ range_iterator_t *range_create_with_bounds(int start, int end) {
 
 range_iterator_t *range_create_with_step(int start, int end, int step) {
   range_iterator_t *range = malloc(sizeof(range_iterator_t));
+  if (range)
+    range_init(range, start, end, step);
+  return range;
+}
+
+void range_init(range_iterator_t *range, int start, int end, int step) {
   range->current = start;
   range->total = end;
   range->step = step;
-  return range;
 }
 
 void range_destroy(range_iterator_t *range) { free(range); }
@@ -1185,4 +1852,70 @@ range_iterator_t *trange_with_bounds(int start, int end) {
 
 range_iterator_t *trange_with_step(int start, int end, int step) {
   return range_create_with_step(start, end, step);
-}
\ No newline at end of file
+}
+
+/* =============================
+ * Range loops (TQDM_FOR)
+ * ============================= */
+#define TQDM_RANGE_STRIDE_MAX 65536
+
+tqdm_range_loop_t *tqdm_range_loop_init(tqdm_range_loop_t *loop, int start,
+                                        int end, int step) {
+  range_init(&loop->range, start, end, step);
+
+  long long span = (long long)end - start;
+  long long stride = step;
+  if (step < 0) {
+    span = -span;
+    stride = -stride;
+  }
+  size_t total = (step != 0 && span > 0)
+                     ? (size_t)((span + stride - 1) / stride)
+                     : 0;
+  return tqdm_loop_init(loop, total, NULL);
+}
+
+tqdm_range_loop_t *tqdm_loop_init(tqdm_range_loop_t *loop, size_t total,
+                                  const tqdm_params_t *params) {
+  tqdm_params_t p = params ? *params : tqdm_static_default_params();
+  if (total > 0)
+    p.total = total;
+
+  /* An empty range still gets a bar so the loop has a uniform shape; a
+   * failed init just runs the loop without one */
+  loop->active = tqdm_init_with_params(&loop->bar, NULL, NULL, 0, &p) != NULL;
+  loop->stride = 1;
+  loop->countdown = 1;
+  loop->last_tick = current_time_seconds();
+  return loop;
+}
+
+/* Credit the finished stride and retune it so updates land about twice per
+ * mininterval, however cheap the loop body is */
+void tqdm_range_loop_tick(tqdm_range_loop_t *loop) {
+  if (loop->active)
+    tqdm_update_n(&loop->bar, loop->stride);
+
+  double now = current_time_seconds();
+  double dt = now - loop->last_tick;
+  double target = loop->active ? loop->bar.params.mininterval / 2 : 0.05;
+
+  if (dt < target / 2 && loop->stride < TQDM_RANGE_STRIDE_MAX)
+    loop->stride *= 2;
+  else if (dt > target * 2 && loop->stride > 1)
+    loop->stride /= 2;
+
+  loop->countdown = loop->stride;
+  loop->last_tick = now;
+}
+
+void tqdm_range_loop_fini(tqdm_range_loop_t *loop) {
+  if (!loop->active)
+    return;
+
+  size_t pending = loop->stride - loop->countdown;
+  if (pending > 0)
+    tqdm_update_n(&loop->bar, pending);
+  tqdm_fini(&loop->bar);
+  loop->active = false;
+}
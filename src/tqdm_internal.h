@@ -0,0 +1,232 @@
+#ifndef TQDM_INTERNAL_H
+#define TQDM_INTERNAL_H
+
+/* Declarations shared between the library's translation units. Not part of
+ * the public API and not installed. */
+
+#include "tqdm/tqdm.h"
+
+/* =============================
+ * Number and time formatting
+ * =============================
+ * Write into caller buffers and return the length written (snprintf
+ * semantics, truncated to size). The public tqdm_format_* wrap these. */
+size_t tqdm_fmt_sizeof(char *buf, size_t size, double num,
+                       const char *suffix, int divisor);
+size_t tqdm_fmt_interval(char *buf, size_t size, double t);
+size_t tqdm_fmt_num(char *buf, size_t size, double n);
+
+/* =============================
+ * Compiled bar formats
+ * ============================= */
+#define TQDM_BAR_MAX_WIDTH 100
+#define TQDM_COLOUR_ESC_SIZE 24
+
+#define TQDM_FIELD_ENUM(name, id, type) TQDM_FIELD_##id,
+typedef enum {
+  TQDM_FIELD_LITERAL,
+  TQDM_FORMAT_FIELDS(TQDM_FIELD_ENUM)
+} tqdm_field_t;
+#undef TQDM_FIELD_ENUM
+
+/* One piece of a bar_format: literal text or a {field[:spec]} */
+typedef struct {
+  unsigned char field;   /* tqdm_field_t */
+  char align;            /* String fields: '<', '>', '^' or 0 */
+  unsigned short width;  /* String fields: minimum width in columns */
+  unsigned short off;    /* Literals: span of the format text */
+  unsigned short len;
+  char conv[16];         /* Numeric fields: printf conversion, "" = default */
+} tqdm_token_t;
+
+typedef struct {
+  const char *text;      /* Source; literals point into it */
+  size_t ntokens;
+  tqdm_token_t tokens[TQDM_FORMAT_MAX_TOKENS];
+} tqdm_format_t;
+
+/* Parse text (Python tqdm's bar_format syntax). False on unknown fields,
+ * bad specs, unbalanced braces or more than TQDM_FORMAT_MAX_TOKENS pieces. */
+bool tqdm_format_compile(tqdm_format_t *fmt, const char *text);
+
+/* Glyphs for the {bar} field */
+typedef struct {
+  const char *full;      /* TQDM_BAR_MAX_WIDTH filled cells */
+  const char *blank;     /* TQDM_BAR_MAX_WIDTH empty cells */
+  size_t cell_bytes;     /* Bytes per cell in `full` */
+  const char *const *partials; /* Eighths of a cell, NULL if none */
+} tqdm_glyphs_t;
+
+/* =============================
+ * Styles
+ * =============================
+ * Everything about a bar's look that does not change per frame. Shared
+ * styles come from tqdm_style_create; bars without one get theirs from
+ * tqdm_style_for_params when they are set up. */
+struct tqdm_style_s {
+  int refs;              /* 0 for stack temporaries */
+  tqdm_params_t params;  /* Template for bars; desc and postfix unused */
+  tqdm_format_t format;  /* Compiled bar_format or the default layout */
+  const tqdm_glyphs_t *glyphs;
+  char colour_on[TQDM_COLOUR_ESC_SIZE]; /* Escape for the bar, "" if none */
+  char strings[];        /* Owned unit, bar_format, colour and
+                          * history_file */
+};
+
+/* Fill style from params, borrowing their strings. An invalid bar_format
+ * falls back to the default layout and returns false. */
+bool tqdm_style_setup(tqdm_style_t *style, const tqdm_params_t *params);
+
+/* A style for a bar created from params alone: compiled once per distinct
+ * look and shared from a small cache. An invalid bar_format gets the
+ * default layout, as it would per frame. NULL without memory. */
+tqdm_style_t *tqdm_style_for_params(const tqdm_params_t *params);
+
+/* Whether the style's format shows field */
+bool tqdm_style_has_field(const tqdm_style_t *style, tqdm_field_t field);
+
+/* =============================
+ * Rendering
+ * ============================= */
+
+/* Per-frame values for one line. For weighted bars n and total are cost,
+ * and the item counts ride along. */
+typedef struct {
+  size_t n;
+  size_t total;          /* 0 when unknown */
+  size_t total_estimate; /* Expected final total, 0 when unknown */
+  size_t items;          /* Weighted bars only */
+  size_t items_total;    /* 0 when unknown */
+  bool weighted;
+  double elapsed;
+  double rate;           /* <= 0 when unknown */
+  double remaining;      /* < 0 when unknown */
+  const char *desc;
+  const char *postfix;
+  const char *phase;     /* Current phase name, or NULL */
+  int ncols;             /* <= 0 when unknown */
+  double spark[TQDM_RATE_HISTORY_SIZE]; /* Recent rates, oldest first */
+  size_t spark_len;
+  double stalled_for;    /* Seconds since progress if stalled, else 0 */
+  double remaining_low;  /* ETA at the high rate quantile, < 0 unknown */
+  double remaining_high; /* ETA at the low rate quantile, < 0 unknown */
+} tqdm_meter_t;
+
+/* Render one frame into buf without allocating. Returns the length. */
+size_t tqdm_render_meter(char *buf, size_t size, const tqdm_meter_t *meter,
+                         const tqdm_style_t *style);
+
+/* =============================
+ * tqdm.c
+ * ============================= */
+
+/* Defaults with the environment applied; strings are not owned */
+tqdm_params_t tqdm_static_default_params(void);
+
+double current_time_seconds(void);
+int get_terminal_width(void);
+
+/* A flush that reports whether the reader is still there; whether output
+ * is discarded at all is checked once per bar (tqdm_output_discarded) */
+bool tqdm_output_flush(FILE *file);
+
+/* tqdm_add_total grows params.total and sets growing without the bar
+ * lock, so every other access to them is atomic as well */
+static inline size_t tqdm_live_total(const tqdm_t *tqdm) {
+  return __atomic_load_n(&tqdm->params.total, __ATOMIC_RELAXED);
+}
+
+static inline bool tqdm_live_growing(const tqdm_t *tqdm) {
+  return __atomic_load_n(&tqdm->growing, __ATOMIC_RELAXED);
+}
+
+/* The run's clock (start, pauses, last progress) is likewise stored
+ * atomically, for dashboards that read members they could not lock */
+static inline double tqdm_live_elapsed(const tqdm_t *tqdm, double now) {
+  double start, paused;
+  __atomic_load(&tqdm->start_time, &start, __ATOMIC_RELAXED);
+  __atomic_load(&tqdm->total_pause_time, &paused, __ATOMIC_RELAXED);
+  return now - start - paused;
+}
+
+static inline double tqdm_live_progress_time(const tqdm_t *tqdm) {
+  double t;
+  __atomic_load(&tqdm->last_progress_time, &t, __ATOMIC_RELAXED);
+  return t;
+}
+
+/* One rendered line, on the stack of whoever draws it */
+#define TQDM_LINE_SIZE 1024
+
+/* Snapshot a bar for rendering, with its lock held, and the style to
+ * render it with (local is filled in for bars without a shared one).
+ * Without the lock only the counters can be sampled. */
+void tqdm_sample_meter(const tqdm_t *tqdm, double now, int ncols,
+                       tqdm_meter_t *meter);
+void tqdm_sample_counters(const tqdm_t *tqdm, double now, int ncols,
+                          tqdm_meter_t *meter);
+const tqdm_style_t *tqdm_bar_style(const tqdm_t *tqdm, tqdm_style_t *local);
+
+/* Draw a frame now, subject to the usual gates; the bar's lock is held */
+void tqdm_redraw_locked(tqdm_t *tqdm);
+
+/* =============================
+ * estimator.c
+ * ============================= */
+void tqdm_quantile_init(tqdm_quantile_t *qt, double p);
+void tqdm_quantile_add(tqdm_quantile_t *qt, double x);
+/* Current estimate; < 0 until TQDM_QUANTILE_MIN_SAMPLES were added */
+double tqdm_quantile_value(const tqdm_quantile_t *qt);
+#define TQDM_QUANTILE_MIN_SAMPLES 5
+
+/* Add an interval's rate; true when it ends the current regime (the
+ * caller starts a new one with tqdm_change_reset) */
+void tqdm_change_reset(tqdm_change_t *c);
+bool tqdm_change_add(tqdm_change_t *c, double x);
+
+/* =============================
+ * history.c
+ * ============================= */
+uint64_t tqdm_history_key(const char *desc, size_t total, size_t cost_total);
+/* Profile stored under key, into marks[TQDM_HISTORY_MARKS] */
+bool tqdm_history_load(const char *path, uint64_t key, float *marks);
+/* Merge a finished run's profile into the file, atomically */
+bool tqdm_history_store(const char *path, uint64_t key, const float *marks);
+
+/* A prior read from the file before taking a bar's lock */
+typedef struct {
+  uint64_t key;
+  bool valid;
+  float marks[TQDM_HISTORY_MARKS];
+} tqdm_history_prior_t;
+
+/* Bar hooks, called with the bar's lock held (or before it is shared):
+ * start from a prior, track this run's profile, hand it back once
+ * complete, and free the run state with the bar. The file is not touched
+ * under the lock: begin takes a prior read ahead (NULL reads it there,
+ * for bars not yet shared), and the caller stores what finish returns
+ * after unlocking. */
+void tqdm_history_begin(tqdm_t *tqdm, const tqdm_history_prior_t *prior);
+void tqdm_history_sample(tqdm_t *tqdm, double t);
+bool tqdm_history_finish(tqdm_t *tqdm, double t, uint64_t *key,
+                         float *marks);
+void tqdm_history_end(tqdm_t *tqdm);
+
+/* Seconds the prior spent between two fractions of the total, or < 0
+ * without one */
+double tqdm_history_span(const tqdm_t *tqdm, double from, double to);
+
+/* Seconds left: the prior's estimate blended into the live one (< 0 when
+ * unknown) over the first part of the run */
+double tqdm_history_remaining(const tqdm_t *tqdm, double fraction,
+                              double elapsed, double live);
+
+/* =============================
+ * group.c
+ * ============================= */
+
+/* A member passed its print gate (its lock is held): redraw the dashboard
+ * unless another thread is drawing or the last frame is too recent */
+void tqdm_group_notify(tqdm_group_t *group, tqdm_t *from);
+
+#endif /* TQDM_INTERNAL_H */
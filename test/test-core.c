@@ -1,10 +1,12 @@
 #include <assert.h>
+#include <fcntl.h>
 #include <math.h>
 #include <pthread.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <time.h>
 #include <unistd.h>
@@ -208,6 +210,31 @@ void test_range(void) {
 
   range_destroy(range);
 
+  // Heap-free range state
+  range_iterator_t local;
+  range_init(&local, 10, 0, -2);
+  count = 0;
+  expected = 10;
+  while (range_has_next(&local)) {
+    TEST_ASSERT_EQ(range_next(&local), expected,
+                   "Local range should count down");
+    expected -= 2;
+    count++;
+  }
+  TEST_ASSERT_EQ(count, 5, "Should iterate 10,8,6,4,2");
+
+  // Loop state used by TQDM_FOR_STEP
+  tqdm_range_loop_t loop;
+  tqdm_range_loop_init(&loop, 0, 20, 3);
+  TEST_ASSERT_EQ(loop.bar.params.total, 7, "Loop bar total should be 7");
+  count = 0;
+  while (tqdm_range_loop_has_next(&loop)) {
+    count++;
+    tqdm_range_loop_advance(&loop);
+  }
+  TEST_ASSERT_EQ(count, 7, "Loop should run 7 times");
+  tqdm_range_loop_fini(&loop);
+
   TEST_PASS();
   TEST_CLEANUP();
 }
@@ -543,6 +570,15 @@ void test_format(void) {
   TEST_ASSERT(strstr(meter, "75%") != NULL, "Should contain percentage");
   free(meter);
 
+  // Custom bar_format: the bar takes whatever columns are left
+  meter = tqdm_format_meter(5, 10, 1.0, 30, "x", true, "it", false, 5.0,
+                            "{desc}|{bar}|{n}/{total} {percentage:5.1f}%",
+                            NULL, 1000, 0, NULL);
+  TEST_ASSERT_NOT_NULL(meter, "format_meter should honour bar_format");
+  TEST_ASSERT_STR_EQ(meter, "x|########        |5/10  50.0%",
+                     "bar_format fields and bar width");
+  free(meter);
+
   TEST_PASS();
   TEST_CLEANUP();
 }
@@ -558,6 +594,7 @@ void test_env(void) {
   setenv("TQDM_MININTERVAL", "0.2", 1);
   setenv("TQDM_UNIT", "bytes", 1);
   setenv("TQDM_UNIT_SCALE", "true", 1);
+  tqdm_reload_env();  // env is cached per process
 
   tqdm_params_t params = tqdm_default_params();
   tqdm_load_env_vars(&params);
@@ -567,6 +604,12 @@ void test_env(void) {
   TEST_ASSERT_STR_EQ(params.unit, "bytes", "Should load unit from env");
   TEST_ASSERT_EQ(params.unit_scale, true, "Should load unit_scale from env");
 
+  // Defaults pick up the cached env too, without another getenv
+  tqdm_params_t defaults = tqdm_default_params();
+  TEST_ASSERT_STR_EQ(defaults.unit, "bytes", "Defaults should apply env");
+  TEST_ASSERT(defaults.unit != params.unit, "Each params owns its unit");
+  tqdm_cleanup_params(&defaults);
+
   unsetenv("TQDM_MININTERVAL");
   unsetenv("TQDM_UNIT");
   unsetenv("TQDM_UNIT_SCALE");
@@ -576,8 +619,1147 @@ void test_env(void) {
     setenv("TQDM_MININTERVAL", orig_mininterval, 1);
   if (orig_unit)
     setenv("TQDM_UNIT", orig_unit, 1);
+  tqdm_reload_env();
+
+  tqdm_cleanup_params(&params);
+
+  TEST_PASS();
+  TEST_CLEANUP();
+}
+
+void test_pool(void) {
+  TEST_START("Pool");
+
+  tqdm_pool_trim();
+
+  tqdm_params_t params = tqdm_default_params();
+  params.desc = strdup("Pooled bar");
+  params.total = 10;
+  params.disable = true;
+
+  tqdm_t *first = tqdm_create_with_params(NULL, NULL, 1, &params);
+  TEST_ASSERT_NOT_NULL(first, "Should create first bar");
+  tqdm_set_description_str(first, "A much longer description than before",
+                           false);
+  tqdm_destroy(first);
+
+  // The next bar on this thread reuses the pooled object in place
+  tqdm_t *second = tqdm_create_with_params(NULL, NULL, 1, &params);
+  TEST_ASSERT(second == first, "Destroyed bar should be reused");
+  TEST_ASSERT_STR_EQ(second->params.desc, "Pooled bar",
+                     "Reused bar should get the new description");
+  TEST_ASSERT_STR_EQ(second->params.unit, "it", "Unit should be set");
+  TEST_ASSERT_EQ(second->n, 0, "Reused bar should start at 0");
+  TEST_ASSERT_EQ(second->closed, false, "Reused bar should be open");
+  tqdm_destroy(second);
+
+  // Churn more bars than the pool holds
+  tqdm_t *bars[TQDM_POOL_MAX + 4];
+  for (int i = 0; i < TQDM_POOL_MAX + 4; i++) {
+    bars[i] = tqdm_create_with_params(NULL, NULL, 1, &params);
+    TEST_ASSERT_NOT_NULL(bars[i], "Should create bar while churning");
+  }
+  for (int i = 0; i < TQDM_POOL_MAX + 4; i++) {
+    tqdm_destroy(bars[i]);
+  }
+
+  tqdm_pool_trim();
+  tqdm_cleanup_params(&params);
+
+  TEST_PASS();
+  TEST_CLEANUP();
+}
+
+typedef struct {
+  int id;
+  tqdm_t bar;  // embedded, no separate allocation
+} test_job_t;
+
+void test_init_storage(void) {
+  TEST_START("Init storage");
+
+  tqdm_params_t params = tqdm_default_params();
+  params.desc = strdup("Stack bar");
+  params.total = 20;
+  params.disable = true;
+
+  tqdm_t bar;
+  TEST_ASSERT(tqdm_init(&bar, &params) == &bar,
+              "tqdm_init should return the storage");
+  TEST_ASSERT_STR_EQ(bar.params.desc, "Stack bar", "Desc should be copied");
+  TEST_ASSERT(bar.params.desc != params.desc,
+              "Desc should not alias the caller's string");
+  TEST_ASSERT((char *)bar.params.desc >= (char *)&bar &&
+                  (char *)bar.params.desc < (char *)(&bar + 1),
+              "Short strings should live inside the bar");
+
+  for (int i = 0; i < 20; i++) {
+    tqdm_update(&bar);
+  }
+  TEST_ASSERT_EQ(bar.n, 0, "Disabled stack bar should not track updates");
+
+  // Longer than the inline arena: spills to the heap, freed by fini
+  char long_desc[TQDM_INLINE_STR_SIZE * 2];
+  memset(long_desc, 'x', sizeof(long_desc) - 1);
+  long_desc[sizeof(long_desc) - 1] = '\0';
+  tqdm_set_description_str(&bar, long_desc, false);
+  TEST_ASSERT_STR_EQ(bar.params.desc, long_desc,
+                     "Long description should be stored");
+  tqdm_fini(&bar);
+
+  // Embedded in another struct, default params
+  test_job_t job = {.id = 7};
+  TEST_ASSERT_NOT_NULL(tqdm_init_with_total(&job.bar, NULL, 5, 0),
+                       "tqdm_init_with_total should succeed");
+  TEST_ASSERT_EQ(job.bar.params.total, 5, "Total should be set");
+  TEST_ASSERT_STR_EQ(job.bar.params.unit, "it", "Default unit");
+  tqdm_fini(&job.bar);
+  TEST_ASSERT_EQ(job.id, 7, "Surrounding struct should be untouched");
+
+  tqdm_cleanup_params(&params);
+
+  TEST_PASS();
+  TEST_CLEANUP();
+}
+
+void test_delay(void) {
+  TEST_START("Delay");
+
+  FILE *out = tmpfile();
+  TEST_ASSERT_NOT_NULL(out, "tmpfile should work");
+
+  tqdm_params_t params = tqdm_default_params();
+  params.total = 100;
+  params.file = out;
+  params.mininterval = 0;
+  params.delay = 5.0f;
+
+  // Creation must not block for the delay
+  double start = get_time_ms();
+  tqdm_t *tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  TEST_ASSERT_NOT_NULL(tqdm, "Should create delayed bar");
+  TEST_ASSERT(get_time_ms() - start < 1000.0, "Create should not sleep");
+
+  for (int i = 0; i < 100; i++) {
+    tqdm_update(tqdm);
+  }
+  TEST_ASSERT_EQ(tqdm->n, 100, "Counters work during the delay");
+  tqdm_destroy(tqdm);
+  TEST_ASSERT_EQ(ftell(out), 0, "A task shorter than the delay draws nothing");
+
+  // Once the delay has passed the bar is drawn as usual
+  params.delay = 0.02f;
+  tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  SLEEP_MS(30);
+  tqdm_update_n(tqdm, 100);
+  tqdm_destroy(tqdm);
+  TEST_ASSERT(ftell(out) > 0, "Bar should appear after the delay");
+
+  fclose(out);
+  params.file = NULL;
+  tqdm_cleanup_params(&params);
+
+  TEST_PASS();
+  TEST_CLEANUP();
+}
+
+void test_style(void) {
+  TEST_START("Style");
+
+  FILE *out = tmpfile();
+  TEST_ASSERT_NOT_NULL(out, "tmpfile should work");
+
+  tqdm_params_t params = tqdm_default_params();
+  params.file = out;
+  params.mininterval = 0;
+  params.ncols = 60;
+  free(params.unit);
+  params.unit = strdup("shards");
+  free(params.colour);
+  params.colour = strdup("green");
+  params.bar_format = strdup("{desc}: {n}/{total} {unit}{percentage:4.0f}%|{bar}|");
+
+  tqdm_style_t *style = tqdm_style_create(&params);
+  TEST_ASSERT_NOT_NULL(style, "Should create style");
+  tqdm_cleanup_params(&params);  // the style keeps its own copies
+
+  tqdm_t *bars[64];
+  for (int i = 0; i < 64; i++) {
+    bars[i] = tqdm_create_with_style(style, "shard", 10);
+    TEST_ASSERT_NOT_NULL(bars[i], "Should create styled bar");
+  }
+  TEST_ASSERT(bars[0]->params.unit == bars[63]->params.unit,
+              "Styled bars should share the unit");
+  TEST_ASSERT_STR_EQ(bars[63]->params.unit, "shards", "Unit from the style");
+
+  // Bars keep the style alive
+  tqdm_style_release(style);
+
+  tqdm_update_n(bars[0], 5);
+  char line[512] = {0};
+  rewind(out);
+  TEST_ASSERT(fread(line, 1, sizeof(line) - 1, out) > 0, "Should draw");
+  TEST_ASSERT(strstr(line, "shard: 5/10 shards  50%|\033[32m") != NULL,
+              "Should render the style's format and colour");
+
+  for (int i = 0; i < 64; i++) {
+    tqdm_destroy(bars[i]);
+  }
+
+  // Caller storage works the same way
+  style = tqdm_style_create(NULL);
+  TEST_ASSERT_NOT_NULL(style, "Should create default style");
+  tqdm_t bar;
+  TEST_ASSERT(tqdm_init_with_style(&bar, style, "stack", 3) == &bar,
+              "tqdm_init_with_style should return the storage");
+  TEST_ASSERT_STR_EQ(bar.params.unit, "it", "Default unit");
+  TEST_ASSERT_EQ(bar.params.total, 3, "Total should be set");
+  tqdm_style_release(style);
+  bar.params.disable = true;
+  tqdm_fini(&bar);
+
+  // Bad formats are rejected up front
+  params = tqdm_default_params();
+  params.bar_format = strdup("{desc} {nope}");
+  TEST_ASSERT_NULL(tqdm_style_create(&params), "Unknown field should fail");
+  tqdm_cleanup_params(&params);
+
+  // Bars without a style share one compiled for their look
+  params = tqdm_default_params();
+  params.file = out;
+  tqdm_t *a = tqdm_create_with_params(NULL, NULL, 0, &params);
+  tqdm_t *b = tqdm_create_with_params(NULL, NULL, 0, &params);
+  TEST_ASSERT(a->style && a->style == b->style,
+              "Same params should share a style");
+  TEST_ASSERT_NULL(a->rate_range, "No quantiles without {eta_range}");
+  tqdm_destroy(b);
+  params.bar_format = strdup("{n} {eta_range}");
+  b = tqdm_create_with_params(NULL, NULL, 0, &params);
+  TEST_ASSERT(b->style != a->style, "Another format is another style");
+  TEST_ASSERT_NOT_NULL(b->rate_range, "{eta_range} needs its quantiles");
+  tqdm_destroy(b);
+  tqdm_destroy(a);
+  params.file = NULL;
+  tqdm_cleanup_params(&params);
+
+  fclose(out);
+
+  TEST_PASS();
+  TEST_CLEANUP();
+}
+
+/* Contents of a temp file after the last occurrence of mark */
+static char *read_after_last(FILE *f, const char *mark) {
+  long size = ftell(f);
+  char *buf = malloc(size + 1);
+  rewind(f);
+  size_t got = fread(buf, 1, size, f);
+  buf[got] = '\0';
+  fseek(f, 0, SEEK_END);
+
+  char *last = buf, *p;
+  while ((p = strstr(last + 1, mark)) != NULL)
+    last = p;
+  memmove(buf, last, strlen(last) + 1);
+  return buf;
+}
+
+void test_group(void) {
+  TEST_START("Group");
+
+  FILE *out = tmpfile();
+  TEST_ASSERT_NOT_NULL(out, "tmpfile should work");
+
+  tqdm_params_t params = tqdm_default_params();
+  params.file = out;
+  params.mininterval = 0;
+  params.ncols = 60;
+  params.desc = strdup("all");
+
+  tqdm_group_t *group = tqdm_group_create(&params, 2, TQDM_GROUP_SLOWEST, 0.05);
+  TEST_ASSERT_NOT_NULL(group, "Should create group");
+
+  tqdm_t *bars[50];
+  char desc[8];
+  params.total = 100;
+  for (int i = 0; i < 50; i++) {
+    snprintf(desc, sizeof(desc), "w%02d", i);
+    free(params.desc);
+    params.desc = strdup(desc);
+    bars[i] = tqdm_create_with_params(NULL, NULL, 1, &params);
+    TEST_ASSERT_NOT_NULL(bars[i], "Should create member");
+    TEST_ASSERT(tqdm_group_add(group, bars[i]), "Should join group");
+  }
+  TEST_ASSERT(!tqdm_group_add(group, bars[0]), "Only one group per bar");
+
+  // 5 finished bars; the rest at n = i, so w05 and w06 are slowest
+  for (int i = 0; i < 50; i++) {
+    tqdm_update_n(bars[i], i < 5 ? 100 : (size_t)i);
+  }
+  tqdm_group_refresh(group);
+
+  char *frame = read_after_last(out, "\033[2A");
+  TEST_ASSERT(strstr(frame, "done=5 active=45 stalled=0") != NULL,
+              "Aggregate row should carry the counts");
+  TEST_ASSERT(strstr(frame, "w05") && strstr(frame, "w06"),
+              "Slowest members should be shown");
+  TEST_ASSERT(strstr(frame, "w49") == NULL, "Fast members should not");
+  int rows = 0;
+  for (char *p = frame; (p = strstr(p, "\r\033[K")) != NULL; p++) {
+    rows++;
+  }
+  TEST_ASSERT_EQ(rows, 3, "Frame should have a fixed number of rows");
+  free(frame);
+
+  // No progress for longer than stall_after
+  SLEEP_MS(80);
+  tqdm_group_refresh(group);
+  frame = read_after_last(out, "\033[2A");
+  TEST_ASSERT(strstr(frame, "stalled=45") != NULL,
+              "Idle members should count as stalled");
+  free(frame);
+
+  // Members leave on destroy; their counts stay in the aggregate
+  for (int i = 0; i < 50; i++) {
+    tqdm_destroy(bars[i]);
+  }
+  tqdm_group_close(group);
+  frame = read_after_last(out, "\033[2A");
+  TEST_ASSERT(strstr(frame, "done=50 active=0 stalled=0") != NULL,
+              "Destroyed members should count as done");
+  free(frame);
+
+  tqdm_group_destroy(group);
+  fclose(out);
+  params.file = NULL;
+  tqdm_cleanup_params(&params);
+
+  TEST_PASS();
+  TEST_CLEANUP();
+}
+
+static void *group_update_worker(void *arg) {
+  for (int i = 0; i < 20000; i++) {
+    tqdm_update(arg);
+  }
+  return NULL;
+}
+
+void test_group_threads(void) {
+  TEST_START("Group membership while updating");
+
+  FILE *out = tmpfile();
+  TEST_ASSERT_NOT_NULL(out, "tmpfile should work");
+  tqdm_params_t params = tqdm_default_params();
+  params.file = out;
+  params.mininterval = 0;
+  params.total = 20000;
+
+  tqdm_group_t *group = tqdm_group_create(&params, 2, TQDM_GROUP_SLOWEST, 1.0);
+  TEST_ASSERT_NOT_NULL(group, "Should create group");
+  tqdm_t *bars[4];
+  pthread_t threads[4];
+  for (int i = 0; i < 4; i++) {
+    bars[i] = tqdm_create_with_params(NULL, NULL, 1, &params);
+    TEST_ASSERT_NOT_NULL(bars[i], "Should create member");
+    TEST_ASSERT(tqdm_group_add(group, bars[i]), "Should join group");
+  }
+  for (int i = 0; i < 4; i++) {
+    pthread_create(&threads[i], NULL, group_update_worker, bars[i]);
+  }
+
+  // Two members leave, then the group goes, while their owners update
+  SLEEP_MS(1);
+  tqdm_group_remove(group, bars[0]);
+  tqdm_group_remove(group, bars[1]);
+  tqdm_group_destroy(group);
+
+  for (int i = 0; i < 4; i++) {
+    pthread_join(threads[i], NULL);
+    TEST_ASSERT_EQ(bars[i]->n, 20000, "Every update should count");
+    TEST_ASSERT_NULL(bars[i]->group, "Every bar should be detached");
+    tqdm_destroy(bars[i]);
+  }
+
+  params.file = NULL;
+  tqdm_cleanup_params(&params);
+  fclose(out);
+
+  TEST_PASS();
+  TEST_CLEANUP();
+}
+
+void test_discarded_output(void) {
+  TEST_START("Discarded output");
+
+  tqdm_params_t params = tqdm_default_params();
+  params.total = 1000;
+  params.mininterval = 0;
+
+  // stderr redirected to /dev/null: no frames, counters still work
+  params.file = fopen("/dev/null", "w");
+  TEST_ASSERT_NOT_NULL(params.file, "Should open /dev/null");
+  tqdm_t *tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  TEST_ASSERT_NOT_NULL(tqdm, "Should create bar");
+  TEST_ASSERT(tqdm->muted, "A /dev/null bar should be muted");
+  for (int i = 0; i < 1000; i++) {
+    tqdm_update(tqdm);
+  }
+  TEST_ASSERT_EQ(tqdm->n, 1000, "Muted bars keep counting");
+  TEST_ASSERT_EQ(tqdm_format_dict(tqdm)->n, 1000, "Stats still work");
+  TEST_ASSERT(!tqdm->displayed, "Nothing should be drawn");
+  tqdm_destroy(tqdm);
+  fclose(params.file);
+
+  // Reader goes away mid-run: the first failed write mutes the bar
+  int fds[2];
+  TEST_ASSERT_EQ(pipe(fds), 0, "pipe should work");
+  void (*old_handler)(int) = signal(SIGPIPE, SIG_IGN);
+  params.file = fdopen(fds[1], "w");
+  tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  TEST_ASSERT(!tqdm->muted, "A pipe with a reader is not muted");
+  tqdm_update(tqdm);
+  close(fds[0]);
+  tqdm_update(tqdm);
+  TEST_ASSERT(tqdm->muted, "EPIPE should mute the bar");
+  tqdm_update_n(tqdm, 10);
+  TEST_ASSERT_EQ(tqdm->n, 12, "Counters survive the broken pipe");
+  tqdm_destroy(tqdm);
+  fclose(params.file);
+  signal(SIGPIPE, old_handler);
+
+  params.file = NULL;
+  tqdm_cleanup_params(&params);
+
+  TEST_PASS();
+  TEST_CLEANUP();
+}
+
+void test_estimator(void) {
+  TEST_START("Estimator");
+
+  TEST_ASSERT(tqdm_estimator_find("ema") == &tqdm_estimator_ema,
+              "Built-ins should be found by name");
+  TEST_ASSERT_NULL(tqdm_estimator_find("nope"), "Unknown names give NULL");
+
+  // 100 s of warmup at 10/s, then 50 s at 1000/s, sampled every 0.1 s
+  tqdm_params_t params = tqdm_default_params();
+  const tqdm_estimator_t *models[] = {&tqdm_estimator_avg, &tqdm_estimator_ema,
+                                      &tqdm_estimator_linreg};
+  double rates[3];
+  for (int m = 0; m < 3; m++) {
+    tqdm_estimator_state_t state;
+    models[m]->reset(&state, &params);
+    TEST_ASSERT(models[m]->rate(&state) <= 0, "Rate unknown before samples");
+    for (int i = 1; i <= 1500; i++) {
+      double t = i * 0.1;
+      double n = t <= 100 ? t * 10 : 1000 + (t - 100) * 1000;
+      models[m]->sample(&state, t, n);
+    }
+    rates[m] = models[m]->rate(&state);
+  }
+  TEST_ASSERT(rates[0] < 400, "avg still remembers the warmup");
+  TEST_ASSERT_FLOAT_EQ(rates[1], 1000.0, 50.0, "ema tracks the current rate");
+  TEST_ASSERT_FLOAT_EQ(rates[2], 1000.0, 50.0,
+                       "linreg tracks the current rate");
+
+  // Auto smoothing: bursty work gets a steady rate, and a steady rate
+  // that shifts is followed within a few seconds
+  params.smoothing = TQDM_SMOOTHING_AUTO;
+  tqdm_estimator_state_t state;
+  tqdm_estimator_ema.reset(&state, &params);
+  double n = 0, lo = 1e9, hi = 0;
+  for (int i = 1; i <= 600; i++) {
+    n += i % 4 == 0 ? 400 : 0; // Bursts averaging 1000/s
+    tqdm_estimator_ema.sample(&state, i * 0.1, n);
+    double rate = tqdm_estimator_ema.rate(&state);
+    if (i > 300 && rate < lo)
+      lo = rate;
+    if (i > 300 && rate > hi)
+      hi = rate;
+  }
+  TEST_ASSERT(lo > 750 && hi < 1250, "Bursty rates should be smoothed");
+
+  tqdm_estimator_ema.reset(&state, &params);
+  for (int i = 1; i <= 600; i++) {
+    double t = i * 0.1;
+    tqdm_estimator_ema.sample(&state, t,
+                              t <= 30 ? t * 100 : 3000 + (t - 30) * 500);
+  }
+  TEST_ASSERT_FLOAT_EQ(tqdm_estimator_ema.rate(&state), 500.0, 5.0,
+                       "A steady rate should be tracked closely");
+  params.smoothing = 0.3f;
+
+  // Bars default to linreg; params and env can pick another
+  params.disable = true;
+  tqdm_t *tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  TEST_ASSERT(tqdm->params.estimator == &tqdm_estimator_linreg,
+              "linreg is the default");
+  tqdm_destroy(tqdm);
+
+  params.smoothing = TQDM_SMOOTHING_AUTO;
+  tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  TEST_ASSERT(tqdm->params.estimator == &tqdm_estimator_ema &&
+                  tqdm->params.smoothing == TQDM_SMOOTHING_AUTO,
+              "Auto smoothing should pick the EMA");
+  tqdm_destroy(tqdm);
+  params.smoothing = 0.3f;
+
+  params.estimator = &tqdm_estimator_avg;
+  tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  TEST_ASSERT(tqdm->params.estimator == &tqdm_estimator_avg,
+              "params.estimator should be used");
+  tqdm_destroy(tqdm);
+
+  setenv("TQDM_ESTIMATOR", "ema", 1);
+  tqdm_reload_env();
+  tqdm_params_t defaults = tqdm_default_params();
+  TEST_ASSERT(defaults.estimator == &tqdm_estimator_ema,
+              "TQDM_ESTIMATOR should select the default");
+  tqdm_cleanup_params(&defaults);
+  unsetenv("TQDM_ESTIMATOR");
+  tqdm_reload_env();
+
+  setenv("TQDM_SMOOTHING", "auto", 1);
+  tqdm_reload_env();
+  defaults = tqdm_default_params();
+  TEST_ASSERT(defaults.smoothing == TQDM_SMOOTHING_AUTO,
+              "TQDM_SMOOTHING=auto should select auto smoothing");
+  tqdm_cleanup_params(&defaults);
+  unsetenv("TQDM_SMOOTHING");
+  tqdm_reload_env();
+
+  tqdm_cleanup_params(&params);
+
+  TEST_PASS();
+  TEST_CLEANUP();
+}
+
+void test_weighted(void) {
+  TEST_START("Weighted update");
+
+  FILE *out = tmpfile();
+  TEST_ASSERT_NOT_NULL(out, "tmpfile should work");
+
+  // Three files, one of which is most of the bytes
+  tqdm_params_t params = tqdm_default_params();
+  params.file = out;
+  params.total = 3;
+  params.cost_total = 1000;
+  params.mininterval = 0;
+  params.ncols = 60;
+  params.estimator = &tqdm_estimator_avg;
+  tqdm_t *tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  TEST_ASSERT_NOT_NULL(tqdm, "Should create bar");
+  TEST_ASSERT(tqdm->weighted, "cost_total makes the bar weighted");
+
+  SLEEP_MS(20);
+  tqdm_update_weighted(tqdm, 1, 900);
+  TEST_ASSERT_EQ(tqdm->n, 1, "Items should be counted");
+  TEST_ASSERT_EQ(tqdm->cost, 900, "Cost should be summed");
+  TEST_ASSERT(tqdm->cached_rate > 1000, "Rate should be in cost units");
+  char *frame = read_after_last(out, "\r");
+  TEST_ASSERT(strstr(frame, " 90%") != NULL, "Bar should follow cost");
+  TEST_ASSERT(strstr(frame, "900/1.00k (1/3)") != NULL,
+              "Both counts should be shown");
+  free(frame);
+
+  // Completion by cost, even with items left
+  tqdm_update_weighted(tqdm, 1, 100);
+  frame = read_after_last(out, "\r");
+  TEST_ASSERT(strstr(frame, "100%") && strstr(frame, "(2/3)"),
+              "Full cost should complete the bar");
+  free(frame);
+  tqdm_destroy(tqdm);
+
+  // Fields for custom layouts; cost total unknown falls back to items
+  params.cost_total = 0;
+  params.bar_format = strdup("{percentage:.0f}|{n}|{items}/{items_total}");
+  tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  TEST_ASSERT(!tqdm->weighted, "Plain until a cost is added");
+  tqdm_update_weighted(tqdm, 2, 4096);
+  TEST_ASSERT(tqdm->weighted, "Adding cost makes the bar weighted");
+  frame = read_after_last(out, "\r");
+  TEST_ASSERT_STR_EQ(frame, "\r67|4096|2/3", "Fields should render");
+  free(frame);
+  tqdm_destroy(tqdm);
+
+  params.file = NULL;
+  tqdm_cleanup_params(&params);
+  fclose(out);
+
+  TEST_PASS();
+  TEST_CLEANUP();
+}
+
+void test_history(void) {
+  TEST_START("Run history");
+
+  char dir[] = "/tmp/tqdm-history-XXXXXX";
+  TEST_ASSERT_NOT_NULL(mkdtemp(dir), "mkdtemp should work");
+  char path[64];
+  snprintf(path, sizeof(path), "%s/history", dir);
+
+  FILE *out = tmpfile();
+  TEST_ASSERT_NOT_NULL(out, "tmpfile should work");
+  tqdm_params_t params = tqdm_default_params();
+  params.file = out;
+  params.desc = strdup("nightly");
+  params.total = 100;
+  params.mininterval = 0;
+  params.history_file = strdup(path);
+  params.bar_format = strdup("{remaining_s:.1f}");
+
+  // First run: no prior, so the ETA is unknown until progress is made
+  tqdm_t *tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  tqdm_refresh(tqdm);
+  char *frame = read_after_last(out, "\r");
+  TEST_ASSERT_STR_EQ(frame, "\r?", "No prior on the first run");
+  free(frame);
+  for (int i = 0; i < 4; i++) {
+    SLEEP_MS(50);
+    tqdm_update_n(tqdm, 25);
+  }
+  tqdm_destroy(tqdm);
+
+  FILE *f = fopen(path, "r");
+  TEST_ASSERT_NOT_NULL(f, "A finished run should be recorded");
+  char line[512];
+  TEST_ASSERT_NOT_NULL(fgets(line, sizeof(line), f), "Entry expected");
+  fclose(f);
+
+  // Second run starts from the recorded 0.2 s
+  tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  TEST_ASSERT(tqdm->history->prior_valid, "Prior should be loaded");
+  TEST_ASSERT_FLOAT_EQ(tqdm->history->prior[TQDM_HISTORY_MARKS - 1], 0.2,
+                       0.05, "Prior covers the whole run");
+  tqdm_refresh(tqdm);
+  frame = read_after_last(out, "\r");
+  TEST_ASSERT(strcmp(frame, "\r?") != 0, "ETA known from the first frame");
+  free(frame);
+  tqdm_update_n(tqdm, 100);
+  tqdm_destroy(tqdm);
+
+  // One entry per key, updated in place
+  f = fopen(path, "r");
+  int lines = 0;
+  while (fgets(line, sizeof(line), f))
+    lines++;
+  fclose(f);
+  TEST_ASSERT_EQ(lines, 1, "Runs with the same key share an entry");
+  TEST_ASSERT(strstr(line, " 2 ") != NULL, "Run count should be kept");
+
+  // A reset reads the prior for its new total
+  tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  tqdm_reset(tqdm, 200);
+  TEST_ASSERT(!tqdm->history->prior_valid, "No prior for a new total");
+  tqdm_reset(tqdm, 100);
+  TEST_ASSERT(tqdm->history->prior_valid, "Reset should load the prior");
+  tqdm_destroy(tqdm);
+
+  // Another total is another key; unfinished runs are not recorded
+  params.total = 200;
+  tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  TEST_ASSERT(!tqdm->history->prior_valid, "Different totals do not match");
+  tqdm_update_n(tqdm, 50);
+  tqdm_destroy(tqdm);
+  tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  TEST_ASSERT(!tqdm->history->prior_valid, "Aborted runs are not recorded");
+  tqdm_destroy(tqdm);
+
+  params.file = NULL;
+  tqdm_cleanup_params(&params);
+  fclose(out);
+  snprintf(line, sizeof(line), "%s.lock", path);
+  unlink(line);
+  unlink(path);
+  rmdir(dir);
+
+  TEST_PASS();
+  TEST_CLEANUP();
+}
+
+void test_history_muted(void) {
+  TEST_START("Run history of a muted bar");
+
+  char dir[] = "/tmp/tqdm-history-XXXXXX";
+  TEST_ASSERT_NOT_NULL(mkdtemp(dir), "mkdtemp should work");
+  char path[64];
+  snprintf(path, sizeof(path), "%s/history", dir);
+
+  FILE *out = fopen("/dev/null", "w");
+  TEST_ASSERT_NOT_NULL(out, "/dev/null should open");
+  tqdm_params_t params = tqdm_default_params();
+  params.file = out;
+  params.desc = strdup("quiet");
+  params.total = 100;
+  params.mininterval = 0;
+  params.history_file = strdup(path);
+
+  // Half the work at once, then a slow second half: the marks follow the
+  // real profile even though no frame is ever drawn
+  tqdm_t *tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  TEST_ASSERT(tqdm->muted, "Output to /dev/null should be muted");
+  tqdm_update_n(tqdm, 50);
+  SLEEP_MS(100);
+  tqdm_update_n(tqdm, 50);
+  tqdm_close(tqdm);
+  TEST_ASSERT_EQ(tqdm->history->next, TQDM_HISTORY_MARKS,
+                 "Every mark should be passed");
+  TEST_ASSERT(tqdm->history->marks[5] < 0.02,
+              "Half the total was reached at once");
+  TEST_ASSERT(tqdm->history->marks[TQDM_HISTORY_MARKS - 1] >= 0.09,
+              "The run ends after the slow half");
+  tqdm_destroy(tqdm);
+
+  // The stored profile is the measured one, not a straight line
+  tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  TEST_ASSERT(tqdm->history->prior_valid, "Prior should be loaded");
+  TEST_ASSERT(tqdm->history->prior[5] < 0.02, "Stored marks follow the run");
+  tqdm_destroy(tqdm);
+
+  params.file = NULL;
+  tqdm_cleanup_params(&params);
+  fclose(out);
+  char lock[80];
+  snprintf(lock, sizeof(lock), "%s.lock", path);
+  unlink(lock);
+  unlink(path);
+  rmdir(dir);
+
+  TEST_PASS();
+  TEST_CLEANUP();
+}
+
+static void *add_total_worker(void *arg) {
+  for (int i = 0; i < 10000; i++) {
+    tqdm_add_total(arg, 1);
+  }
+  return NULL;
+}
+
+void test_add_total(void) {
+  TEST_START("Growing total");
+
+  FILE *out = tmpfile();
+  TEST_ASSERT_NOT_NULL(out, "tmpfile should work");
+  tqdm_params_t params = tqdm_default_params();
+  params.file = out;
+  params.total = 1000;
+  params.mininterval = 0;
+  params.estimator = &tqdm_estimator_avg;
+  params.bar_format = strdup("{total}|{total_est}");
+  tqdm_t *tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+
+  // Crawler: 200 more found while 600 were processed. The backlog of 600
+  // drains at 400/s net, during which another 300 turn up.
+  SLEEP_MS(20);
+  tqdm_add_total(tqdm, 200);
+  TEST_ASSERT_EQ(tqdm->params.total, 1200, "Total should grow");
+  tqdm_update_n(tqdm, 600);
+  char *frame = read_after_last(out, "\r");
+  TEST_ASSERT_STR_EQ(frame, "\r1200|1500", "Final total is estimated");
+  free(frame);
+
+  // Discovery outpacing processing has no end in sight
+  tqdm_add_total(tqdm, 2000);
+  tqdm_refresh(tqdm);
+  frame = read_after_last(out, "\r");
+  TEST_ASSERT_STR_EQ(frame, "\r3200|?", "No estimate while work piles up");
+  free(frame);
+  tqdm_destroy(tqdm);
+
+  // Producers on other threads
+  params.file = NULL;
+  params.disable = true;
+  tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  pthread_t threads[4];
+  for (int i = 0; i < 4; i++) {
+    pthread_create(&threads[i], NULL, add_total_worker, tqdm);
+  }
+  for (int i = 0; i < 4; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  TEST_ASSERT_EQ(tqdm->params.total, 41000, "No increments should be lost");
+  tqdm_destroy(tqdm);
+
+  tqdm_cleanup_params(&params);
+  fclose(out);
+
+  TEST_PASS();
+  TEST_CLEANUP();
+}
+
+void test_sparkline(void) {
+  TEST_START("Sparkline");
+
+  FILE *out = tmpfile();
+  TEST_ASSERT_NOT_NULL(out, "tmpfile should work");
+  tqdm_params_t params = tqdm_default_params();
+  params.file = out;
+  params.total = 1000;
+  params.mininterval = 0.01f;
+  params.ascii = true;
+  params.bar_format = strdup("[{sparkline}]");
+  tqdm_t *tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+
+  tqdm_refresh(tqdm);
+  char *frame = read_after_last(out, "\r");
+  TEST_ASSERT_STR_EQ(frame, "\r[          ]", "Blank before any samples");
+  free(frame);
+
+  // Steady, then a stall, then steady again
+  for (int i = 0; i < 3; i++) {
+    SLEEP_MS(20);
+    tqdm_update_n(tqdm, 10);
+  }
+  SLEEP_MS(20);
+  tqdm_refresh(tqdm);
+  SLEEP_MS(20);
+  tqdm_update_n(tqdm, 10);
+  frame = read_after_last(out, "\r");
+  TEST_ASSERT_EQ(strlen(frame), 13, "One cell per sample slot");
+  TEST_ASSERT(strncmp(frame, "\r[     ", 7) == 0,
+              "Unused slots should be blank");
+  TEST_ASSERT_EQ(frame[10], ' ', "The stall should show as a gap");
+  TEST_ASSERT(frame[9] != ' ' && frame[11] != ' ',
+              "Progress around it should show");
+  free(frame);
+  tqdm_destroy(tqdm);
+
+  params.file = NULL;
+  tqdm_cleanup_params(&params);
+  fclose(out);
+
+  TEST_PASS();
+  TEST_CLEANUP();
+}
+
+typedef struct {
+  int stalled;
+  int resumed;
+  int closed;
+  bool close_on_stall;
+} stall_log_t;
+
+static void on_stall_event(tqdm_t *tqdm, tqdm_event_t event, void *data) {
+  stall_log_t *log = data;
+  if (event == TQDM_EVENT_STALLED) {
+    __atomic_add_fetch(&log->stalled, 1, __ATOMIC_SEQ_CST);
+    if (log->close_on_stall) {
+      tqdm_close(tqdm);
+      __atomic_store_n(&log->closed, 1, __ATOMIC_SEQ_CST);
+    }
+  } else if (event == TQDM_EVENT_RESUMED) {
+    __atomic_add_fetch(&log->resumed, 1, __ATOMIC_SEQ_CST);
+  }
+}
+
+void test_stall(void) {
+  TEST_START("Stall detection");
+
+  FILE *out = tmpfile();
+  TEST_ASSERT_NOT_NULL(out, "tmpfile should work");
+  stall_log_t log = {0};
+  tqdm_params_t params = tqdm_default_params();
+  params.file = out;
+  params.total = 100;
+  params.mininterval = 0;
+  params.stall_timeout = 0.05f;
+  params.on_event = on_stall_event;
+  params.on_event_data = &log;
+  params.bar_format = strdup("{rate_fmt}");
+
+  tqdm_t *tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  tqdm_update_n(tqdm, 10);
+  SLEEP_MS(200);
+  TEST_ASSERT_EQ(__atomic_load_n(&log.stalled, __ATOMIC_SEQ_CST), 1,
+                 "The monitor should report the stall once");
+  TEST_ASSERT(__atomic_load_n(&tqdm->stalled, __ATOMIC_SEQ_CST),
+              "The bar should be marked stalled");
+  char *frame = read_after_last(out, "\r");
+  TEST_ASSERT(strncmp(frame, "\rSTALLED ", 9) == 0,
+              "The rate field should show the stall");
+  free(frame);
+
+  tqdm_update_n(tqdm, 10);
+  frame = read_after_last(out, "\r");
+  TEST_ASSERT(strstr(frame, "STALLED") == NULL,
+              "Progress should clear it at once");
+  free(frame);
+  SLEEP_MS(30);
+  TEST_ASSERT_EQ(__atomic_load_n(&log.resumed, __ATOMIC_SEQ_CST), 1,
+                 "The monitor should report the resume");
+  tqdm_destroy(tqdm);
+
+  // Callbacks may close the bar they are called for
+  log.close_on_stall = true;
+  tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  SLEEP_MS(200);
+  TEST_ASSERT(__atomic_load_n(&log.closed, __ATOMIC_SEQ_CST),
+              "The callback should have closed the bar");
+  TEST_ASSERT(tqdm->closed, "The bar should be closed");
+  TEST_ASSERT(!tqdm->monitored, "Closed bars leave the monitor");
+  tqdm_destroy(tqdm);
+
+  params.file = NULL;
+  tqdm_cleanup_params(&params);
+  fclose(out);
+
+  TEST_PASS();
+  TEST_CLEANUP();
+}
+
+void test_phase(void) {
+  TEST_START("Phases");
+
+  FILE *out = tmpfile();
+  TEST_ASSERT_NOT_NULL(out, "tmpfile should work");
+  tqdm_params_t params = tqdm_default_params();
+  params.file = out;
+  params.total = 1000;
+  params.mininterval = 0;
+  params.ncols = 60;
+  params.desc = strdup("job");
+  params.estimator = &tqdm_estimator_avg;
+  tqdm_t *tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+
+  tqdm_phase_begin(tqdm, "scan", 0.1);
+  char *frame = read_after_last(out, "\r");
+  TEST_ASSERT(strncmp(frame, "\rjob [scan]: ", 13) == 0,
+              "The phase should follow desc");
+  free(frame);
+  tqdm_update_n(tqdm, 100);
+  tqdm_phase_begin(tqdm, "write", 0);
+  TEST_ASSERT_EQ(tqdm->rate_origin_n, 100, "Rates restart with the phase");
+  TEST_ASSERT_STR_EQ(tqdm->phase_name, "write", "Phase name is kept");
+  tqdm_destroy(tqdm);
+
+  // 10 s in: scanning 100 took 9 s, then 100 were transformed in 1 s.
+  // Transform ends at 300 at its own 100/s, and the 700 after it go at
+  // the run's average (no history) of 20/s.
+  params.bar_format = strdup("{phase}|{rate:.0f}|{remaining_s:.0f}");
+  tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+  tqdm_phase_begin(tqdm, "scan", 0.1);
+  tqdm_update_n(tqdm, 100);
+  tqdm_phase_begin(tqdm, "transform", 0.2);
+  tqdm->start_time -= 10;
+  tqdm->rate_origin_time = 9;
+  tqdm_update_n(tqdm, 100);
+  frame = read_after_last(out, "\r");
+  TEST_ASSERT_STR_EQ(frame, "\rtransform|100|36",
+                     "ETA should add up the phases");
+  free(frame);
+
+  // Overrunning its expected end, the phase counts as done and the rest
+  // goes at the run's average
+  tqdm_update_n(tqdm, 300);
+  frame = read_after_last(out, "\r");
+  TEST_ASSERT_STR_EQ(frame, "\rtransform|400|10", "Overrun phase");
+  free(frame);
+
+  tqdm_reset(tqdm, 0);
+  TEST_ASSERT(!tqdm->phased && !tqdm->phase_name, "Reset clears phases");
+  tqdm_destroy(tqdm);
+
+  tqdm_cleanup_params(&params);
+  fclose(out);
+
+  TEST_PASS();
+  TEST_CLEANUP();
+}
+
+/* Seconds in a "[H:]MM:SS" interval */
+static double parse_interval(const char *s) {
+  double secs = 0;
+  char *end;
+  for (;;) {
+    secs = secs * 60 + strtol(s, &end, 10);
+    if (*end != ':')
+      return secs;
+    s = end + 1;
+  }
+}
+
+void test_eta_range(void) {
+  TEST_START("ETA range");
+
+  FILE *out = tmpfile();
+  TEST_ASSERT_NOT_NULL(out, "tmpfile should work");
+  tqdm_params_t params = tqdm_default_params();
+  params.file = out;
+  params.total = 1000000;
+  params.mininterval = 0.01f;
+  params.ascii = true;
+  params.bar_format = strdup("{remaining}|{eta_range}");
+  tqdm_t *tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+
+  SLEEP_MS(20);
+  tqdm_update_n(tqdm, 10);
+  char *frame = read_after_last(out, "\r");
+  TEST_ASSERT(strstr(frame, "|?") != NULL, "Unknown until rates are seen");
+  free(frame);
+
+  // Bursty: intervals of 10 and 100 items
+  for (int i = 0; i < 12; i++) {
+    SLEEP_MS(20);
+    tqdm_update_n(tqdm, i % 2 ? 100 : 10);
+  }
+  frame = read_after_last(out, "\r");
+  const char *range = strchr(frame, '|');
+  const char *dash = range ? strchr(range, '-') : NULL;
+  TEST_ASSERT(range && dash, "A range should be shown");
+  double eta = parse_interval(frame + 1);
+  double lo = parse_interval(range + 1), hi = parse_interval(dash + 1);
+  TEST_ASSERT(lo <= eta && eta <= hi, "The range should hold the ETA");
+  TEST_ASSERT(hi >= 2 * lo, "Bursty rates should give a wide range");
+  free(frame);
+  tqdm_destroy(tqdm);
+
+  params.file = NULL;
+  tqdm_cleanup_params(&params);
+  fclose(out);
+
+  TEST_PASS();
+  TEST_CLEANUP();
+}
+
+static void on_rate_event(tqdm_t *tqdm, tqdm_event_t event, void *data) {
+  (void)tqdm;
+  if (event == TQDM_EVENT_RATE_CHANGE)
+    __atomic_add_fetch((int *)data, 1, __ATOMIC_SEQ_CST);
+}
+
+void test_rate_change(void) {
+  TEST_START("Rate change");
+
+  FILE *out = tmpfile();
+  TEST_ASSERT_NOT_NULL(out, "tmpfile should work");
+  int changes = 0;
+  tqdm_params_t params = tqdm_default_params();
+  params.file = out;
+  params.total = 1000000;
+  params.mininterval = 0.01f;
+  params.estimator = &tqdm_estimator_avg;
+  params.on_event = on_rate_event;
+  params.on_event_data = &changes;
+  params.bar_format = strdup("{rate:.0f}");
+  tqdm_t *tqdm = tqdm_create_with_params(NULL, NULL, 1, &params);
+
+  // Steady at 500/s, then ten times faster: the average since the shift
+  // is shown, not the one since the start
+  for (int i = 0; i < 10; i++) {
+    SLEEP_MS(20);
+    tqdm_update_n(tqdm, 10);
+  }
+  TEST_ASSERT_EQ(tqdm->rate_origin_n, 0, "No change while steady");
+  for (int i = 0; i < 3; i++) {
+    SLEEP_MS(20);
+    tqdm_update_n(tqdm, 100);
+  }
+  TEST_ASSERT(tqdm->rate_origin_n >= 100, "The shift should be detected");
+  char *frame = read_after_last(out, "\r");
+  TEST_ASSERT(atof(frame + 1) > 3500, "The new rate should be shown");
+  free(frame);
+
+  // Reported from the monitor thread
+  for (int i = 0; i < 300 && !__atomic_load_n(&changes, __ATOMIC_SEQ_CST);
+       i++)
+    SLEEP_MS(10);
+  TEST_ASSERT_EQ(__atomic_load_n(&changes, __ATOMIC_SEQ_CST), 1,
+                 "The change should be reported once");
+  tqdm_destroy(tqdm);
+
+  params.file = NULL;
+  tqdm_cleanup_params(&params);
+  fclose(out);
+
+  TEST_PASS();
+  TEST_CLEANUP();
+}
+
+void test_copy_fd(void) {
+  TEST_START("Copy fd");
+
+  FILE *out = tmpfile();
+  FILE *src = tmpfile();
+  FILE *dst = tmpfile();
+  TEST_ASSERT(out && src && dst, "tmpfile should work");
+  tqdm_params_t params = tqdm_default_params();
+  params.file = out;
+  params.mininterval = 0;
+
+  // 3 MiB with two blocks of data and holes around them
+  char block[4096];
+  for (size_t i = 0; i < sizeof(block); i++)
+    block[i] = (char)('a' + i % 26);
+  int in = fileno(src), dup_out = fileno(dst);
+  TEST_ASSERT(pwrite(in, block, sizeof(block), 0) == sizeof(block) &&
+                  pwrite(in, block, sizeof(block), 2 << 20) ==
+                      sizeof(block) &&
+                  ftruncate(in, 3 << 20) == 0,
+              "Input should be written");
+
+  ssize_t copied = tqdm_copy_fd(in, dup_out, 0, &params);
+  TEST_ASSERT_EQ(copied, 3 << 20, "The whole input should be copied");
+  struct stat in_st, out_st;
+  TEST_ASSERT(fstat(in, &in_st) == 0 && fstat(dup_out, &out_st) == 0,
+              "fstat should work");
+  TEST_ASSERT_EQ(out_st.st_size, 3 << 20, "Trailing hole should be kept");
+  TEST_ASSERT_EQ(lseek(dup_out, 0, SEEK_CUR), 3 << 20,
+                 "Output offset should follow the copy");
+  char back[sizeof(block)], zeros[sizeof(block)] = {0};
+  TEST_ASSERT(pread(dup_out, back, sizeof(back), 2 << 20) == sizeof(back) &&
+                  !memcmp(back, block, sizeof(block)),
+              "Data should be copied");
+  TEST_ASSERT(pread(dup_out, back, sizeof(back), 1 << 20) == sizeof(back) &&
+                  !memcmp(back, zeros, sizeof(zeros)),
+              "Holes should read as zeros");
+  if (in_st.st_blocks * 512 < in_st.st_size)
+    TEST_ASSERT(out_st.st_blocks * 512 < out_st.st_size,
+                "A sparse input should give a sparse output");
+  char *frame = read_after_last(out, "\r");
+  TEST_ASSERT(strstr(frame, "3MB/3MB") != NULL,
+              "The bar should count bytes");
+  free(frame);
+
+  // A pipe has no size: copy to its end
+  int fds[2];
+  TEST_ASSERT_EQ(pipe(fds), 0, "pipe should work");
+  for (int i = 0; i < 8; i++)
+    TEST_ASSERT(write(fds[1], block, sizeof(block)) == sizeof(block),
+                "Pipe should take 32K");
+  close(fds[1]);
+  TEST_ASSERT(ftruncate(dup_out, 0) == 0 && lseek(dup_out, 0, SEEK_SET) == 0,
+              "Output should be reset");
+  copied = tqdm_copy_fd(fds[0], dup_out, 0, &params);
+  close(fds[0]);
+  TEST_ASSERT_EQ(copied, 8 * (ssize_t)sizeof(block),
+                 "Everything in the pipe should be copied");
+  TEST_ASSERT(pread(dup_out, back, sizeof(back), 28672) == sizeof(back) &&
+                  !memcmp(back, block, sizeof(block)),
+              "Pipe data should arrive in order");
+
+  // procfs files report no size but have content
+  int proc = open("/proc/self/status", O_RDONLY);
+  if (proc >= 0) {
+    TEST_ASSERT(ftruncate(dup_out, 0) == 0 &&
+                    lseek(dup_out, 0, SEEK_SET) == 0,
+                "Output should be reset");
+    copied = tqdm_copy_fd(proc, dup_out, 0, &params);
+    close(proc);
+    TEST_ASSERT(copied > 0, "A sizeless file should be copied to its end");
+    TEST_ASSERT(fstat(dup_out, &out_st) == 0 && out_st.st_size == copied,
+                "Every byte read should be written");
+    TEST_ASSERT(pread(dup_out, back, 5, 0) == 5 && !memcmp(back, "Name:", 5),
+                "procfs content should be copied");
+  }
 
+  params.file = NULL;
   tqdm_cleanup_params(&params);
+  fclose(dst);
+  fclose(src);
+  fclose(out);
 
   TEST_PASS();
   TEST_CLEANUP();
@@ -601,6 +1783,24 @@ int main(void) {
   test_edge();
   test_memory();
   test_threading();
+  test_pool();
+  test_init_storage();
+  test_delay();
+  test_style();
+  test_group();
+  test_group_threads();
+  test_discarded_output();
+  test_estimator();
+  test_weighted();
+  test_history();
+  test_history_muted();
+  test_add_total();
+  test_sparkline();
+  test_stall();
+  test_phase();
+  test_eta_range();
+  test_rate_change();
+  test_copy_fd();
 
   print_test_summary();
 
@@ -0,0 +1,445 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "tqdm/execution.hpp"
+#include "tqdm/tqdm.hpp"
+
+/* Test framework macros */
+#define TEST_ASSERT(condition, message)                                      \
+  do {                                                                       \
+    if (!(condition)) {                                                      \
+      fprintf(stderr, "❌ FAIL: %s\n", message);                             \
+      return false;                                                          \
+    }                                                                        \
+  } while (0)
+
+#define TEST_PASS(message)                                                   \
+  do {                                                                       \
+    printf("✓ %s\n", message);                                               \
+    return true;                                                             \
+  } while (0)
+
+/* Bars write to a temporary file so the final frame can be inspected */
+static tqdm_params_t capture_params(FILE *out) {
+  tqdm_params_t params = tqdm_default_params();
+  params.file = out;
+  params.mininterval = 0;
+  return params;
+}
+
+/* Text after the last carriage return, i.e. the final frame */
+static std::string final_frame(FILE *out) {
+  std::string text;
+  char buf[4096];
+  size_t len;
+  rewind(out);
+  while ((len = fread(buf, 1, sizeof(buf), out)) > 0)
+    text.append(buf, len);
+  size_t cr = text.rfind('\r');
+  return cr == std::string::npos ? text : text.substr(cr + 1);
+}
+
+static bool test_bar_raii(void) {
+  printf("\n=== Testing tqdm::bar ===\n");
+
+  FILE *out = tmpfile();
+  TEST_ASSERT(out, "tmpfile failed");
+  tqdm_params_t params = capture_params(out);
+  params.total = 10;
+
+  {
+    tqdm::bar a(params);
+    TEST_ASSERT(a, "Bar should be created");
+    a.update(3);
+    TEST_ASSERT(a.get()->n == 3, "update should count");
+
+    tqdm::bar b = std::move(a);
+    TEST_ASSERT(!a && b, "Move should transfer ownership");
+    a.update(); /* Empty bar: a no-op */
+    b.update_to(10);
+    TEST_ASSERT(b.get()->n == 10, "update_to should set the count");
+
+    tqdm_t *raw = b.release();
+    TEST_ASSERT(!b, "release should empty the bar");
+    b.reset(raw);
+    TEST_ASSERT(b.get() == raw, "reset should adopt the bar");
+  }
+  TEST_ASSERT(final_frame(out).find("10/10") != std::string::npos,
+              "Destruction should draw the final frame");
+
+  tqdm_cleanup_params(&params);
+  fclose(out);
+  TEST_PASS("tqdm::bar ownership test");
+}
+
+static bool test_view_vector(void) {
+  printf("\n=== Testing tqdm::view (vector) ===\n");
+
+  FILE *out = tmpfile();
+  TEST_ASSERT(out, "tmpfile failed");
+  tqdm_params_t params = capture_params(out);
+
+  std::vector<int> values(500);
+  for (size_t i = 0; i < values.size(); i++)
+    values[i] = (int)i;
+
+  long sum = 0;
+  for (int &x : tqdm::view(values, params)) {
+    sum += x;
+    x = -x; /* Lvalue ranges are iterated in place */
+  }
+  TEST_ASSERT(sum == 499 * 500 / 2, "Every element should be visited");
+  TEST_ASSERT(values[10] == -10, "Elements should be references");
+  TEST_ASSERT(final_frame(out).find("500/500") != std::string::npos,
+              "The bar should count every iteration");
+
+  tqdm_cleanup_params(&params);
+  fclose(out);
+  TEST_PASS("tqdm::view vector test");
+}
+
+static bool test_view_owned_and_break(void) {
+  printf("\n=== Testing tqdm::view (rvalue, early exit) ===\n");
+
+  FILE *out = tmpfile();
+  TEST_ASSERT(out, "tmpfile failed");
+  tqdm_params_t params = capture_params(out);
+
+  /* A temporary is moved into the view; a list has no random access but
+   * still has a size */
+  int count = 0;
+  for (int x : tqdm::view(std::list<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9},
+                          params)) {
+    if (x == 5)
+      break;
+    count++;
+  }
+  TEST_ASSERT(count == 5, "Loop should stop at the break");
+  TEST_ASSERT(final_frame(out).find("| 5/10") != std::string::npos,
+              "Only completed iterations should count");
+
+  tqdm_cleanup_params(&params);
+  fclose(out);
+  TEST_PASS("tqdm::view rvalue test");
+}
+
+static bool test_view_ranges(void) {
+  printf("\n=== Testing tqdm::view (std::ranges) ===\n");
+
+#if defined(__cpp_lib_ranges)
+  using view_t = tqdm::range_view<std::vector<int> &>;
+  static_assert(std::ranges::input_range<view_t>);
+  static_assert(std::ranges::view<view_t>);
+
+  FILE *out = tmpfile();
+  TEST_ASSERT(out, "tmpfile failed");
+  tqdm_params_t params = capture_params(out);
+
+  std::vector<int> values{1, 2, 3, 4, 5, 6};
+  int odd = 0;
+  for (int x : tqdm::view(values, params) |
+                   std::views::filter([](int v) { return v % 2; }))
+    odd += x;
+  TEST_ASSERT(odd == 9, "Adaptors should see every element");
+  TEST_ASSERT(final_frame(out).find("6/6") != std::string::npos,
+              "Filtered-out elements are still iterations");
+
+  tqdm_cleanup_params(&params);
+  fclose(out);
+#endif
+  TEST_PASS("tqdm::view ranges test");
+}
+
+static bool test_parallel(void) {
+  printf("\n=== Testing tqdm::for_each / transform_reduce ===\n");
+
+#if defined(__cpp_lib_execution)
+  FILE *out = tmpfile();
+  TEST_ASSERT(out, "tmpfile failed");
+  tqdm_params_t params = capture_params(out);
+
+  std::vector<int> values(500);
+  std::iota(values.begin(), values.end(), 1);
+
+  std::atomic<long> sum{0};
+  tqdm::for_each(
+      std::execution::par, values.begin(), values.end(),
+      [&sum](int x) { sum.fetch_add(x, std::memory_order_relaxed); },
+      params);
+  TEST_ASSERT(sum == 500L * 501 / 2, "for_each should visit every element");
+  TEST_ASSERT(final_frame(out).find("500/500") != std::string::npos,
+              "for_each should count every element");
+
+  long squares = tqdm::transform_reduce(
+      std::execution::par, values.begin(), values.end(), 0L, std::plus<>(),
+      [](int x) { return (long)x * x; }, params);
+  TEST_ASSERT(squares == 500L * 501 * 1001 / 6,
+              "transform_reduce should match the standard result");
+  TEST_ASSERT(final_frame(out).find("500/500") != std::string::npos,
+              "transform_reduce should count every element");
+
+  tqdm_cleanup_params(&params);
+  fclose(out);
+#endif
+  TEST_PASS("tqdm parallel algorithms test");
+}
+
+static bool test_basic_bar(void) {
+  printf("\n=== Testing tqdm::basic_bar ===\n");
+
+  FILE *out = tmpfile();
+  TEST_ASSERT(out, "tmpfile failed");
+  tqdm_params_t params = capture_params(out);
+  params.total = 100;
+  params.mininterval = 1.0f;
+
+  /* Time moves only by hand: one update every 1/8 s */
+  {
+    tqdm::basic_bar<tqdm::policy::unlocked_lock, tqdm::policy::plain_counter,
+                    tqdm::policy::virtual_clock>
+        b(params);
+    for (int i = 0; i < 40; i++) {
+      b.clock().advance(0.125);
+      b.update();
+    }
+    TEST_ASSERT(b.n() == 40, "The counter should see every update");
+  }
+  std::string frame = final_frame(out);
+  TEST_ASSERT(frame.find("40/100 [00:05<00:07, 8it/s]") !=
+                  std::string::npos,
+              "Elapsed, ETA and rate should follow the virtual clock");
+
+  /* One frame per mininterval of virtual time, and the final one */
+  int frames = 0;
+  int c;
+  rewind(out);
+  while ((c = fgetc(out)) != EOF)
+    frames += c == '\r';
+  TEST_ASSERT(frames == 6, "Frames should be gated by mininterval");
+
+  /* Many writers */
+  {
+    tqdm::basic_bar<tqdm::policy::atomic_lock, tqdm::policy::sharded_counter,
+                    tqdm::policy::coarse_clock>
+        b(params);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+      threads.emplace_back([&b] {
+        for (int i = 0; i < 2500; i++)
+          b.update();
+      });
+    for (std::thread &t : threads)
+      t.join();
+    TEST_ASSERT(b.n() == 10000, "Sharded counts should add up");
+  }
+  {
+    tqdm::basic_bar<> b(params);
+    b.update(7);
+    TEST_ASSERT(b.n() == 7, "The default policies should count");
+  }
+
+  tqdm_cleanup_params(&params);
+  fclose(out);
+  TEST_PASS("tqdm::basic_bar test");
+}
+
+/* The params a tqdm_t honours beyond the look: disable, delay, miniters */
+static bool test_basic_bar_params(void) {
+  printf("\n=== Testing tqdm::basic_bar params ===\n");
+
+  using virtual_bar =
+      tqdm::basic_bar<tqdm::policy::unlocked_lock,
+                      tqdm::policy::plain_counter, tqdm::policy::virtual_clock>;
+  FILE *out = tmpfile();
+  TEST_ASSERT(out, "tmpfile failed");
+  tqdm_params_t params = capture_params(out);
+  params.total = 100;
+
+  /* Disabled: counts, writes nothing, not even the closing newline */
+  params.disable = true;
+  {
+    virtual_bar b(params);
+    for (int i = 0; i < 100; i++) {
+      b.clock().advance(0.5);
+      b.update();
+    }
+    TEST_ASSERT(b.n() == 100, "A disabled bar should still count");
+  }
+  fseek(out, 0, SEEK_END);
+  TEST_ASSERT(ftell(out) == 0, "A disabled bar should write nothing");
+  params.disable = false;
+
+  /* Delayed: nothing before the delay, frames after it */
+  params.delay = 2.0f;
+  {
+    virtual_bar b(params);
+    for (int i = 0; i < 3; i++) {
+      b.clock().advance(0.5);
+      b.update();
+    }
+    fseek(out, 0, SEEK_END);
+    TEST_ASSERT(ftell(out) == 0, "Nothing should be drawn before the delay");
+    b.clock().advance(1.0);
+    b.update();
+    TEST_ASSERT(final_frame(out).find("4/100") != std::string::npos,
+                "The bar should appear once the delay has passed");
+  }
+  {
+    FILE *quick = tmpfile();
+    TEST_ASSERT(quick, "tmpfile failed");
+    params.file = quick;
+    {
+      virtual_bar b(params);
+      b.clock().advance(0.5);
+      b.update(100);
+    }
+    fseek(quick, 0, SEEK_END);
+    long written = ftell(quick);
+    fclose(quick);
+    params.file = out;
+    TEST_ASSERT(written == 0, "A bar closed within its delay never appears");
+  }
+  params.delay = 0;
+
+  /* miniters: a frame per 10 updates, and the final one */
+  fclose(out);
+  out = tmpfile();
+  TEST_ASSERT(out, "tmpfile failed");
+  params.file = out;
+  params.miniters = 10;
+  {
+    virtual_bar b(params);
+    for (int i = 0; i < 25; i++) {
+      b.clock().advance(0.5);
+      b.update();
+    }
+  }
+  int frames = 0;
+  int c;
+  rewind(out);
+  while ((c = fgetc(out)) != EOF)
+    frames += c == '\r';
+  TEST_ASSERT(frames == 3, "Frames should be gated by miniters");
+
+  params.file = nullptr;
+  tqdm_cleanup_params(&params);
+  fclose(out);
+  TEST_PASS("tqdm::basic_bar params test");
+}
+
+#if defined(__cpp_nontype_template_args) &&                                  \
+    __cpp_nontype_template_args >= 201911L
+template <size_t N>
+static constexpr bool valid_format(const char (&text)[N]) {
+  return tqdm::detail::format_valid(text, N - 1);
+}
+#endif
+
+static bool test_format(void) {
+  printf("\n=== Testing tqdm::format ===\n");
+
+#if defined(__cpp_nontype_template_args) &&                                  \
+    __cpp_nontype_template_args >= 201911L
+  static_assert(valid_format("{desc}: {percentage:3.0f}%|{bar}| {n}"));
+  static_assert(valid_format("{{literal}} {n_fmt:>8}"));
+  static_assert(!valid_format("{nope}"), "Unknown field");
+  static_assert(!valid_format("{n:^5}"), "Centred number");
+  static_assert(!valid_format("{desc:.2f}"), "Numeric spec on a string");
+  static_assert(!valid_format("{bar"), "Unclosed brace");
+  static_assert(!valid_format("n}"), "Stray closing brace");
+
+  using fmt = tqdm::format<"{desc}: {n}/{total} [{unit}]">;
+  TEST_ASSERT(fmt::style() && fmt::style() == fmt::style(),
+              "The shared style should be built once");
+
+  FILE *out = tmpfile();
+  TEST_ASSERT(out, "tmpfile failed");
+  tqdm_params_t params = capture_params(out);
+  params.total = 10;
+  params.desc = const_cast<char *>("job");
+  {
+    tqdm::bar b = fmt::make(params);
+    b.update(10);
+  }
+  params.desc = nullptr;
+  TEST_ASSERT(final_frame(out).find("job: 10/10 [it]") != std::string::npos,
+              "The bar should render in the checked format");
+
+  tqdm_cleanup_params(&params);
+  fclose(out);
+#endif
+  TEST_PASS("tqdm::format test");
+}
+
+/* The compile-time check and the C format compiler must agree on every
+ * field and on the token limit */
+static bool test_format_table(void) {
+  printf("\n=== Testing tqdm::format field table ===\n");
+
+#if defined(__cpp_nontype_template_args) &&                                  \
+    __cpp_nontype_template_args >= 201911L
+  using tqdm::detail::format_style;
+  using tqdm::detail::format_valid;
+  using tqdm::detail::style_ref;
+
+  for (const tqdm::detail::format_field &f : tqdm::detail::format_fields) {
+    std::string text = std::string("{") + f.name + "}";
+    TEST_ASSERT(format_valid(text.c_str(), text.size()),
+                "Every listed field should pass the check");
+    style_ref ref{format_style(nullptr, text.c_str())};
+    TEST_ASSERT(ref.style, "Every listed field should compile in C");
+  }
+
+  /* Alternating fields and literals, up to the limit and one past it */
+  std::string most;
+  for (size_t i = 0; i < tqdm::detail::format_max_tokens; i++)
+    most += i % 2 ? "-" : "{n}";
+  TEST_ASSERT(format_valid(most.c_str(), most.size()),
+              "A format at the token limit should pass the check");
+  {
+    style_ref ref{format_style(nullptr, most.c_str())};
+    TEST_ASSERT(ref.style, "A format at the token limit should compile");
+  }
+  most += "{n}";
+  TEST_ASSERT(!format_valid(most.c_str(), most.size()),
+              "A format past the token limit should fail the check");
+  {
+    style_ref ref{format_style(nullptr, most.c_str())};
+    TEST_ASSERT(!ref.style, "A format past the token limit should not compile");
+  }
+#endif
+  TEST_PASS("tqdm::format field table test");
+}
+
+int main(void) {
+  printf("🧪 TQDM C++ Interface Test Suite\n");
+  printf("================================\n");
+
+  bool (*tests[])(void) = {
+      test_bar_raii,
+      test_view_vector,
+      test_view_owned_and_break,
+      test_view_ranges,
+      test_parallel,
+      test_format,
+      test_format_table,
+      test_basic_bar,
+      test_basic_bar_params,
+  };
+  int total = (int)(sizeof(tests) / sizeof(tests[0]));
+  int passed = 0;
+  for (int i = 0; i < total; i++)
+    passed += tests[i]();
+
+  printf("\n📊 Results: %d/%d tests passed\n", passed, total);
+  return passed == total ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,214 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Built with -DTQDM_DISABLE_ALL: every bar call must be an inline no-op and
+ * the loop macros plain loops. Only the params helpers come from the
+ * library. */
+#include "tqdm/tqdm.h"
+
+#ifndef TQDM_DISABLED_H
+#error "test_disable must be compiled with -DTQDM_DISABLE_ALL"
+#endif
+
+/* Test framework macros */
+#define TEST_ASSERT(condition, message)                                      \
+  do {                                                                       \
+    if (!(condition)) {                                                      \
+      fprintf(stderr, "❌ FAIL: %s\n", message);                             \
+      return false;                                                          \
+    }                                                                        \
+  } while (0)
+
+#define TEST_PASS(message)                                                   \
+  do {                                                                       \
+    printf("✓ %s\n", message);                                               \
+    return true;                                                             \
+  } while (0)
+
+static bool test_loops(void) {
+  printf("\n=== Testing loop macros as plain loops ===\n");
+
+  int sum = 0;
+  TQDM_FOR(int, i, 0, 10) { sum += i; }
+  TEST_ASSERT(sum == 45, "TQDM_FOR should visit 0..9");
+
+  int count = 0;
+  TQDM_FOR_STEP(int, i, 10, 0, -3) {
+    TEST_ASSERT(i == 10 - 3 * count, "TQDM_FOR_STEP should count down");
+    count++;
+  }
+  TEST_ASSERT(count == 4, "TQDM_FOR_STEP should visit 10,7,4,1");
+
+  int arr[] = {1, 2, 3, 4};
+  sum = 0;
+  TQDM_FOR_ARRAY(int *, p, arr, 4) { sum += *p; }
+  TEST_ASSERT(sum == 10, "TQDM_FOR_ARRAY should visit every element");
+
+  /* Steps by element, not by the loop variable's type */
+  count = 0;
+  TQDM_FOR_ARRAY(const char *, p, arr, 4) {
+    TEST_ASSERT(p == (const char *)&arr[count],
+                "TQDM_FOR_ARRAY should step an element at a time");
+    count++;
+  }
+  TEST_ASSERT(count == 4, "A mismatched type should still visit 4 elements");
+
+  count = 0;
+  TQDM_MANUAL(pbar, 5) {
+    for (int i = 0; i < 5; i++) {
+      count++;
+      TQDM_UPDATE(pbar);
+    }
+  }
+  TEST_ASSERT(count == 5, "TQDM_MANUAL body should run once");
+
+  TQDM_FOR(int, i, 0, 100) {
+    if (i == 3)
+      break;
+    count++;
+  }
+  TEST_ASSERT(count == 8, "break should work in plain loops");
+
+  TEST_PASS("Loop macros");
+}
+
+typedef struct {
+  int next, end;
+  bool destroyed;
+} counter_t;
+
+static void *counter_next(void *state) {
+  counter_t *c = state;
+  c->next++;
+  return c;
+}
+static bool counter_has_next(void *state) {
+  counter_t *c = state;
+  return c->next < c->end;
+}
+static void counter_destroy(void *state) {
+  ((counter_t *)state)->destroyed = true;
+}
+
+static bool test_iteration(void) {
+  printf("\n=== Testing hand-written iteration loops ===\n");
+
+  int arr[] = {1, 2, 3, 4};
+  int sum = 0;
+  tqdm_t *bar = tqdm_create(arr, arr + 4, sizeof(int));
+  TEST_ASSERT(bar != NULL, "Array create should not fail");
+  while (tqdm_has_next(bar))
+    sum += *(int *)tqdm_next(bar);
+  tqdm_destroy(bar);
+  TEST_ASSERT(sum == 10, "Loop body should run over the array");
+
+  int visited = 0;
+  bar = tqdm_create_with_total(arr, 3, sizeof(int));
+  while (tqdm_has_next(bar)) {
+    visited += *(int *)tqdm_next(bar);
+  }
+  tqdm_destroy(bar);
+  TEST_ASSERT(visited == 6, "A total should bound the loop");
+
+  counter_t c = {0, 5, false};
+  int steps = 0;
+  bar = tqdm_create_iterator(&c, counter_next, counter_has_next,
+                             counter_destroy);
+  TEST_ASSERT(bar != NULL, "Iterator create should not fail");
+  while (tqdm_has_next(bar)) {
+    TEST_ASSERT(tqdm_next(bar) == &c, "next should be forwarded");
+    steps++;
+  }
+  tqdm_destroy(bar);
+  TEST_ASSERT(steps == 5, "Loop body should run over the iterator");
+  TEST_ASSERT(c.destroyed, "destroy_func should be called");
+
+  sum = 0;
+  TQDM_FOR_ARRAY(int *, p, arr, 4) { sum += *p; }
+  TEST_ASSERT(sum == 10, "Stack bars should iterate too");
+
+  /* Contexts are usable and pass the stream through */
+  FILE *f = tmpfile();
+  TEST_ASSERT(f, "tmpfile failed");
+  tqdm_wrapattr_context_t *ctx = tqdm_wrapattr(f, "write", 0, true, NULL);
+  TEST_ASSERT(ctx && ctx->stream == f, "wrapattr should give a context");
+  TEST_ASSERT(ctx->write_func("abc", 1, 3, ctx->stream) == 3,
+              "Writes should reach the stream");
+  tqdm_wrapattr_exit(ctx);
+  tqdm_external_write_context_t *ew = tqdm_external_write_mode(f, false);
+  TEST_ASSERT(ew && ew->original_file == f,
+              "external_write_mode should give a context");
+  tqdm_external_write_mode_exit(ew);
+  fclose(f);
+
+  TEST_PASS("Hand-written iteration loops");
+}
+
+static bool test_calls(void) {
+  printf("\n=== Testing inline no-op calls ===\n");
+
+  tqdm_t *bar = tqdm_create_with_total(NULL, 100, 0);
+  TEST_ASSERT(bar != NULL, "Disabled create should not look like a failure");
+  for (int i = 0; i < 100; i++)
+    tqdm_update(bar);
+  tqdm_update_n(bar, 10);
+  tqdm_update_weighted(bar, 1, 4096);
+  tqdm_add_total(bar, 10);
+  tqdm_set_description(bar, "ignored");
+  TEST_ASSERT(bar->n == 0, "Disabled updates should not count");
+  tqdm_close(bar);
+  tqdm_destroy(bar);
+
+  tqdm_t storage;
+  TEST_ASSERT(tqdm_init(&storage, NULL) == &storage,
+              "Disabled init should hand back the storage");
+  tqdm_fini(&storage);
+
+  tqdm_style_t *style = tqdm_style_create(NULL);
+  TEST_ASSERT(style != NULL, "Disabled style create should not fail");
+  TEST_ASSERT(tqdm_create_with_style(style, "shard", 10) != NULL,
+              "Disabled styled create should not fail");
+  tqdm_style_release(style);
+
+  /* Helpers that return owned memory are still real */
+  tqdm_params_t params = tqdm_default_params();
+  TEST_ASSERT(params.unit && strcmp(params.unit, "it") == 0,
+              "Params helpers should stay real");
+  tqdm_cleanup_params(&params);
+
+  /* A copy has to happen even without its bar */
+  FILE *src = tmpfile(), *dst = tmpfile();
+  TEST_ASSERT(src && dst, "tmpfile failed");
+  fputs("disabled but copied", src);
+  fflush(src);
+  rewind(src);
+  TEST_ASSERT(tqdm_copy_fd(fileno(src), fileno(dst), 0, NULL) == 19,
+              "tqdm_copy_fd should still copy");
+  char back[32] = {0};
+  rewind(dst);
+  TEST_ASSERT(fread(back, 1, sizeof(back) - 1, dst) == 19 &&
+                  strcmp(back, "disabled but copied") == 0,
+              "Copied bytes should match");
+  fclose(dst);
+  fclose(src);
+
+  TEST_PASS("Inline no-op calls");
+}
+
+int main(void) {
+  printf("=== TQDM_DISABLE_ALL TEST SUITE ===\n");
+
+  bool (*tests[])(void) = {test_loops, test_iteration, test_calls};
+  int total_tests = sizeof(tests) / sizeof(tests[0]);
+  int passed_tests = 0;
+
+  for (int i = 0; i < total_tests; i++) {
+    if (tests[i]()) {
+      passed_tests++;
+    }
+  }
+
+  printf("\nTests passed: %d/%d\n", passed_tests, total_tests);
+  return passed_tests == total_tests ? 0 : 1;
+}
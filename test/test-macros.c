@@ -111,6 +111,24 @@ static bool test_tqdm_for_array(void) {
   TEST_PASS("TQDM_FOR_ARRAY test");
 }
 
+/* Test TQDM_FOR_ARRAY with a loop type other than the element pointer;
+ * test-disable checks the plain loop visits the same elements */
+static bool test_tqdm_for_array_bytes(void) {
+  printf("\n=== Testing TQDM_FOR_ARRAY (Byte pointer) ===\n");
+
+  int test_array[] = {10, 20, 30, 40};
+  iteration_count = 0;
+
+  TQDM_FOR_ARRAY(const char *, ptr, test_array, 4) {
+    TEST_ASSERT(ptr == (const char *)&test_array[iteration_count],
+                "Should step an element at a time");
+    iteration_count++;
+  }
+
+  TEST_ASSERT(iteration_count == 4, "Expected 4 iterations");
+  TEST_PASS("TQDM_FOR_ARRAY byte pointer test");
+}
+
 /* Test TQDM_FOR_ARRAY with strings */
 static bool test_tqdm_for_array_strings(void) {
   printf("\n=== Testing TQDM_FOR_ARRAY (Strings) ===\n");
@@ -274,6 +292,7 @@ int main(void) {
       test_tqdm_for_basic,      test_tqdm_for_negative,
       test_tqdm_for_step,       test_tqdm_for_step_large,
       test_tqdm_for_array,      test_tqdm_for_array_strings,
+      test_tqdm_for_array_bytes,
       test_tqdm_manual,         test_tqdm_manual_nested,
       test_nested_macros,       test_macro_with_break,
       test_macro_with_continue, test_macro_memory_safety,